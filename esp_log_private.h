@@ -1,6 +1,90 @@
 #pragma once
+#include <stdarg.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sdkconfig.h"
 
 void esp_log_impl_lock(void);
 bool esp_log_impl_lock_timeout(void);
 void esp_log_impl_unlock(void);
+
+// log.c - set by esp_log_panic_mode(); lock functions and producers check it
+extern uint8_t esp_log_in_panic;
+
+// log_freertos.c - per-task log context block, TLS pointer at CONFIG_LOG_TLS_INDEX
+typedef struct log_task_ctx {
+	char ts_buf[18];								// "HH:MM:SS.sss" rendered for this task
+	char Prefix[24];								// "taskname[core]", built on first log
+	uint8_t PrefixLen;								// 0 = not yet rendered
+	uint8_t Shared;									// the fallback block (ISR / pre-scheduler)
+	#if CONFIG_LOG_LINE_ASSEMBLY
+	struct log_task_ctx * Next;						// registry chain for the timeout sweep
+	const char * Tag;								// tag of the pending fragment(s)
+	uint32_t LastTick;								// tick count of the newest fragment
+	uint16_t Len;									// assembled bytes, 0 = nothing pending
+	uint8_t Prio;									// priority of the pending fragment(s)
+	char Line[CONFIG_LOG_LINE_ASSEMBLY_SIZE];
+	#endif
+} log_task_ctx_t;
+log_task_ctx_t * esp_log_task_ctx_get(void);
+log_task_ctx_t * esp_log_task_ctx_list(void);
+
+// log_linux.c - writev()-batched host sink for benchmark / fuzzing builds
+void esp_log_host_write(const char * text, size_t len);
+void esp_log_host_flush(void);
+void esp_log_host_set_fd(int fd);
+
+// log.c - shared output tail for records formatted outside esp_log_writev()
+void vLogTextEmit(int Priority, const char * MsgID, const char * Text);
+
+// log.c (log_linux.c on the host) - by-reference bulk output of pre-rendered text,
+// level NOT yet syslog adjusted; slices are dispatched without copy or NUL
+void vLogBulkEmit(int level, const char * MsgID, const char * pcText, size_t Len);
+
+// log_format.c - formatting kernel for the common %d/%u/%x/%s subset, vsnprintf
+// return contract; disabled it compiles away to vsnprintf at every call site
+#if CONFIG_LOG_FAST_FORMAT
+int xLogFastFormat(char * pcBuf, size_t Size, const char * format, va_list args);
+#else
+#define xLogFastFormat(pcBuf, Size, format, args)	vsnprintf(pcBuf, Size, format, args)
+#endif
+
+// log_line.c - per-task assembly of partial writes (CONFIG_LOG_LINE_ASSEMBLY)
+int xLogLineAssemble(int Priority, const char * MsgID, const char * format, va_list args);
+void vLogLineSweep(void);
+
+// log_compress.c - streaming LZSS stage for byte-stream sinks (CONFIG_LOG_COMPRESS)
+typedef void (*log_compress_out_t)(void * Ctx, const uint8_t * pcData, size_t Len);
+void vLogCompressInit(log_compress_out_t Out, void * Ctx);
+void vLogCompressWrite(const uint8_t * pcData, size_t Len);
+void vLogCompressFlush(void);
+
+// log_defer.c - lock-free deferred output engine (CONFIG_LOG_DEFERRED)
+int xLogDeferEnqueue(int Priority, const char * MsgID, const char * format, va_list args);
+int xLogDeferEnqueueText(int Priority, const char * MsgID, const char * Text);
+void vLogDeferFlush(void);
+uint32_t ulLogDeferDropCount(void);
+
+// log_sinks.c - registry + fan-out of formatted records (CONFIG_LOG_SINKS)
+void vLogSinkDispatch(int prio, const char * tag, const char * text, size_t len);
+void vLogSinkFlushAll(void);
+uint32_t ulLogSinkFlushMaxUs(int handle);
+
+// log_stats.c - per-core pipeline health counters (CONFIG_LOG_STATS)
+void vLogStatsLevel(int Level);
+void vLogStatsLockTimeout(void);
+void vLogStatsReport(void);
+
+// log_boot.c - early-boot capture buffer, replayed after scheduler start (CONFIG_LOG_BOOT_DEFER)
+int xLogBootCapture(int level, const char * tag, const char * format, va_list args);
+void vLogBootReplay(void);
+
+// log_ratelimit.c - per-callsite token buckets + repeat aggregation (CONFIG_LOG_RATELIMIT)
+int xLogRateLimitCheck(int Priority, const char * tag, const char * format);
+void vLogRateLimitSweep(void);
+
+// log_dram.c - crash-safe DRAM ring of recent WARN+ records (CONFIG_LOG_DRAM_RING)
+void vLogDramAppend(uint8_t Level, const char * Tag, const char * Fmt, va_list Args);
+const void * pvLogDramRing(uint32_t * pCount);
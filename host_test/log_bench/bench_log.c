@@ -0,0 +1,194 @@
+/*
+ * bench_log.c - host-side benchmarks for the logging hot path
+ * Copyright (c) 2024 Andre M. Maree / KSS Technologies (Pty) Ltd.
+ *
+ * Measures the pieces of the pipeline that are host-buildable (log_linux.c):
+ * lock/unlock cost, lock contention scaling across threads, timestamp cost
+ * and the vsnprintf formatting stage that dominates a synchronous ESP_LOGI.
+ * Output is CSV "benchmark,value,unit" on stdout for per-commit tracking.
+ * With the parity build (log_buffers.c on the host) it also measures hexdump
+ * encode throughput and the writev()-batched host sink.
+ */
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "esp_log_private.h"
+
+// ########################################### Macros ##############################################
+
+#define	benchLOCK_ITERS				1000000
+#define	benchFMT_ITERS				500000
+#define	benchTS_ITERS				1000000
+#define	benchTHREADS				4
+
+uint32_t esp_log_timestamp(void);
+
+// ##################################### private functions #########################################
+
+static uint64_t xBenchNowNs(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void vBenchReport(const char * name, double value, const char * unit) {
+	printf("%s,%.2f,%s\n", name, value, unit);
+}
+
+static void * pvBenchLockThread(void * pvArg) {
+	int iters = *(int *) pvArg;
+	for (int i = 0; i < iters; ++i) {
+		esp_log_impl_lock();
+		esp_log_impl_unlock();
+	}
+	return NULL;
+}
+
+static void vBenchLockSingle(void) {
+	uint64_t t0 = xBenchNowNs();
+	for (int i = 0; i < benchLOCK_ITERS; ++i) {
+		esp_log_impl_lock();
+		esp_log_impl_unlock();
+	}
+	uint64_t t1 = xBenchNowNs();
+	vBenchReport("lock_unlock_single", (double) (t1 - t0) / benchLOCK_ITERS, "ns/op");
+}
+
+static void vBenchLockContended(void) {
+	pthread_t threads[benchTHREADS];
+	int iters = benchLOCK_ITERS / benchTHREADS;
+	uint64_t t0 = xBenchNowNs();
+	for (int i = 0; i < benchTHREADS; ++i)
+		pthread_create(&threads[i], NULL, pvBenchLockThread, &iters);
+	for (int i = 0; i < benchTHREADS; ++i)
+		pthread_join(threads[i], NULL);
+	uint64_t t1 = xBenchNowNs();
+	vBenchReport("lock_unlock_contended", (double) (t1 - t0) / benchLOCK_ITERS, "ns/op");
+}
+
+static void vBenchTimestamp(void) {
+	volatile uint32_t sink = 0;
+	uint64_t t0 = xBenchNowNs();
+	for (int i = 0; i < benchTS_ITERS; ++i)
+		sink += esp_log_timestamp();
+	uint64_t t1 = xBenchNowNs();
+	(void) sink;
+	vBenchReport("timestamp", (double) (t1 - t0) / benchTS_ITERS, "ns/op");
+}
+
+static void vBenchFormat(void) {
+	// the formatting stage of a typical ESP_LOGI line, 90% integer/string args
+	char buf[160];
+	volatile int sink = 0;
+	uint64_t t0 = xBenchNowNs();
+	for (int i = 0; i < benchFMT_ITERS; ++i)
+		sink += snprintf(buf, sizeof(buf), "connected ap=%s rssi=%d chan=%u flags=0x%08x", "testnet", -63 + (i & 7), i & 13, i);
+	uint64_t t1 = xBenchNowNs();
+	(void) sink;
+	vBenchReport("format_line", (double) (t1 - t0) / benchFMT_ITERS, "ns/op");
+}
+
+// same line through the CONFIG_LOG_FAST_FORMAT kernel (log_format.c)
+static int xBenchFastFmt(char * buf, size_t size, const char * format, ...) {
+	va_list args;
+	va_start(args, format);
+	int len = xLogFastFormat(buf, size, format, args);
+	va_end(args);
+	return len;
+}
+
+static void vBenchFormatFast(void) {
+	char buf[160];
+	volatile int sink = 0;
+	uint64_t t0 = xBenchNowNs();
+	for (int i = 0; i < benchFMT_ITERS; ++i)
+		sink += xBenchFastFmt(buf, sizeof(buf), "connected ap=%s rssi=%d chan=%u flags=0x%08x", "testnet", -63 + (i & 7), i & 13, i);
+	uint64_t t1 = xBenchNowNs();
+	(void) sink;
+	vBenchReport("format_line_fast", (double) (t1 - t0) / benchFMT_ITERS, "ns/op");
+}
+
+#ifdef LOG_BENCH_HAVE_BUFFERS
+#include <fcntl.h>
+#include "esp_log.h"
+
+// host implementation of the output entry point log_buffers.c renders into:
+// format once, hand to the writev()-batched host sink in log_linux.c
+void esp_log_write(esp_log_level_t level, const char * tag, const char * format, ...) {
+	(void) level;
+	(void) tag;
+	char buf[512];
+	va_list args;
+	va_start(args, format);
+	int len = vsnprintf(buf, sizeof(buf) - 1, format, args);
+	va_end(args);
+	if (len < 0)
+		return;
+	if (len >= (int) sizeof(buf) - 1)
+		len = sizeof(buf) - 2;
+	buf[len++] = '\n';
+	esp_log_host_write(buf, len);
+}
+
+static void vBenchHostSink(void) {
+	static const char rec[] = "I (12345) bench: representative 80 byte record for the writev batching sink path\n";
+	const int iters = 500000;
+	uint64_t t0 = xBenchNowNs();
+	for (int i = 0; i < iters; ++i)
+		esp_log_host_write(rec, sizeof(rec) - 1);
+	esp_log_host_flush();
+	uint64_t t1 = xBenchNowNs();
+	vBenchReport("host_sink_writev", (double) (t1 - t0) / iters, "ns/op");
+}
+
+static void vBenchHexdump(void) {
+	static char payload[1536];						// typical radio frame
+	for (size_t i = 0; i < sizeof(payload); ++i)
+		payload[i] = (char) i;
+	const int iters = 2000;
+	uint64_t t0 = xBenchNowNs();
+	for (int i = 0; i < iters; ++i)
+		esp_log_buffer_hexdump_internal("bench", payload, sizeof(payload), ESP_LOG_INFO);
+	uint64_t t1 = xBenchNowNs();
+	double secs = (double) (t1 - t0) / 1e9;
+	vBenchReport("hexdump_throughput", ((double) sizeof(payload) * iters / secs) / 1048576.0, "MB/s");
+}
+
+static void vBenchCharBulk(void) {
+	static char payload[4096];						// multi-KB AT command transcript
+	for (size_t i = 0; i < sizeof(payload); ++i)
+		payload[i] = (i % 64 == 63) ? '\n' : 'A' + (char) (i % 26);
+	const int iters = 5000;
+	uint64_t t0 = xBenchNowNs();
+	for (int i = 0; i < iters; ++i)
+		esp_log_buffer_char_internal("bench", payload, sizeof(payload), ESP_LOG_INFO);
+	uint64_t t1 = xBenchNowNs();
+	double secs = (double) (t1 - t0) / 1e9;
+	vBenchReport("char_bulk_throughput", ((double) sizeof(payload) * iters / secs) / 1048576.0, "MB/s");
+}
+#endif
+
+// ############################################ main ###############################################
+
+int main(void) {
+	vBenchLockSingle();
+	vBenchLockContended();
+	vBenchTimestamp();
+	vBenchFormat();
+	vBenchFormatFast();
+	#ifdef LOG_BENCH_HAVE_BUFFERS
+	int fd = open("/dev/null", O_WRONLY);			// sink output, measure our cost not the tty's
+	if (fd >= 0)
+		esp_log_host_set_fd(fd);
+	vBenchHostSink();
+	vBenchHexdump();
+	vBenchCharBulk();
+	esp_log_host_flush();
+	#endif
+	return 0;
+}
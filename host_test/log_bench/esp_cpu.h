@@ -0,0 +1,13 @@
+// Minimal host stand-in for the CPU intrinsics pulled in by esp_log.h
+#pragma once
+#include <stdint.h>
+
+static inline uint32_t esp_cpu_get_core_id(void)
+{
+    return 0;
+}
+
+static inline uint32_t esp_cpu_get_cycle_count(void)
+{
+    return 0;
+}
@@ -0,0 +1,4 @@
+// Minimal host stand-in for the ROM console API pulled in by esp_log.h
+#pragma once
+#include <stdio.h>
+#define esp_rom_printf printf
@@ -0,0 +1,3 @@
+// shim so log_linux.c's "../log/esp_log_private.h" include resolves when the
+// component checkout directory is not literally named "log" (see CMakeLists.txt)
+#include "../../../esp_log_private.h"
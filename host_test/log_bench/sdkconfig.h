@@ -0,0 +1,7 @@
+// sdkconfig stand-in for the host build: esp_log.h and esp_log_private.h pull
+// it in for the CONFIG_LOG_xxx options; optional stages all default disabled.
+#pragma once
+#define CONFIG_IDF_TARGET_LINUX 1
+#define CONFIG_LOG_DEFAULT_LEVEL 3
+#define CONFIG_LOG_MAXIMUM_LEVEL 5
+#define CONFIG_LOG_FAST_FORMAT 1
@@ -9,7 +9,34 @@
 #include "esp_rom_sys.h"
 #include "esp_cpu.h"
 
-// only here if we do not disable COREDUMP_LOGS in original SDK. 
+/* ########################## Per-component compiled-in level bounds ###############################
+ * Declare every component's maximum compiled-in level in ONE project header,
+ * log_levels_project.h, anywhere on the include path:
+ *		#define LOG_LEVEL_wifi		ESP_LOG_INFO
+ *		#define LOG_LEVEL_sensors	ESP_LOG_WARN
+ * and have each source file name its component BEFORE including esp_log.h:
+ *		#define LOG_LOCAL_COMPONENT	wifi
+ * LOG_LOCAL_LEVEL then resolves to the central bound at preprocessing time, the
+ * `level <= LOG_LOCAL_LEVEL` test in every ESP_LOGx below folds to a constant
+ * and GCC discards the disabled statement outright - argument evaluation,
+ * runtime branch AND format string literal, so capped levels cost zero flash.
+ * A component named but missing from the central header fails the build (the
+ * pasted LOG_LEVEL_xxx token is undeclared), it cannot silently default open.
+ * An explicit LOG_LOCAL_LEVEL in the file still wins over the central bound.
+ * tools/log_strip_check.py verifies a built image against the source tree, use
+ * it as a post-build step to guarantee release images carry no D/V text. */
+#if defined(__has_include)
+	#if __has_include("log_levels_project.h")
+		#include "log_levels_project.h"
+	#endif
+#endif
+#if !defined(LOG_LOCAL_LEVEL) && defined(LOG_LOCAL_COMPONENT)
+	#define _LOG_LEVEL_PASTE2(c)	LOG_LEVEL_ ## c
+	#define _LOG_LEVEL_PASTE(c)		_LOG_LEVEL_PASTE2(c)
+	#define LOG_LOCAL_LEVEL			_LOG_LEVEL_PASTE(LOG_LOCAL_COMPONENT)
+#endif
+
+// only here if we do not disable COREDUMP_LOGS in original SDK.
 #include "esp_log_level.h"
 #include "esp_log_color.h"
 
@@ -110,6 +137,17 @@ char* esp_log_system_timestamp(void);
  */
 uint32_t esp_log_early_timestamp(void);
 
+/**
+ * @brief 64-bit monotonic timestamp which does not wrap at ~49 days
+ *
+ * Maintained via a seqlock over the RTOS tick count: readers never take the
+ * log mutex and the call is safe from ISR context. Resolution is one RTOS
+ * tick; use for long-uptime ordering, not for microsecond-level profiling.
+ *
+ * @return timestamp, in microseconds
+ */
+uint64_t esp_log_timestamp64(void);
+
 /**
  * @brief Write message into the log
  *
@@ -131,6 +169,46 @@ void esp_log_writev(esp_log_level_t level, const char* tag, const char* format,
 
 void vSyslog(int Priority, const char * MsgID, const char * format, ...);
 
+/**
+ * @brief Switch the log component to its panic output path: lock-free,
+ *        allocation-free and synchronous. Flushes any records still queued in
+ *        the deferred rings, then routes every subsequent message directly to
+ *        the output. Call from the panic handler before printing state; there
+ *        is no way back short of a reset.
+ */
+void esp_log_panic_mode(void);
+
+/**
+ * @brief Pre-rendered "taskname[core]" prefix for the calling task, cached in
+ *        its thread-local log context on the first log call: one TLS load and
+ *        a memcpy per message for downstream formatters instead of a
+ *        pcTaskGetName() lookup-and-format cycle.
+ * @param len optional out, strlen of the returned prefix
+ * @return NUL terminated prefix, "early" before the scheduler runs / in ISRs
+ */
+const char * esp_log_task_prefix(uint8_t * len);
+
+#if CONFIG_LOG_STATS
+/**
+ * @brief Aggregated logging pipeline health counters, see esp_log_stats_get()
+ */
+typedef struct esp_log_stats_t {
+	uint32_t MsgCount[6];		/*!< accepted messages per level, ESP_LOG_NONE..ESP_LOG_VERBOSE */
+	uint32_t LockTimeouts;		/*!< esp_log_impl_lock_timeout() expiries (the 10 ms path fired) */
+	uint32_t RingDrops;			/*!< deferred ring + ISR pool records dropped */
+#if CONFIG_LOG_SINKS
+	uint32_t SinkFlushMaxUs[CONFIG_LOG_SINK_MAX];	/*!< per-sink flush latency high-water marks */
+#endif
+} esp_log_stats_t;
+
+/**
+ * @brief Snapshot the pipeline health counters (cheap, sums the per-core slots).
+ *        A one-line self-report also goes out every CONFIG_LOG_STATS_PERIOD
+ *        seconds under the "logstats" tag.
+ */
+void esp_log_stats_get(esp_log_stats_t * psStats);
+#endif	// CONFIG_LOG_STATS
+
 #include "esp_log_internal.h"
 
 #ifndef LOG_LOCAL_LEVEL
@@ -230,6 +308,25 @@ void vSyslog(int Priority, const char * MsgID, const char * format, ...);
         }																		\
     } while(0)
 
+#if CONFIG_LOG_DUMP_ASYNC
+/**
+ * @brief Asynchronous variant of ESP_LOG_BUFFER_HEXDUMP
+ *
+ * Snapshots the buffer into a static pool and returns immediately; encoding and
+ * output happen in the log drain task, interleaved fairly with normal messages.
+ * Oversized buffers and pool exhaustion degrade to a truncated dump, the caller
+ * is never blocked for the duration of the encode.
+ */
+void esp_log_buffer_hexdump_async(const char *tag, const void *buffer, uint16_t buff_len, esp_log_level_t log_level);
+
+#define ESP_LOG_BUFFER_HEXDUMP_ASYNC( tag, buffer, buff_len, level )		\
+    do {																	\
+        if ((level) <= LOG_LOCAL_LEVEL) { 									\
+            esp_log_buffer_hexdump_async( tag, buffer, buff_len, level);	\
+        }																	\
+    } while(0)
+#endif	// CONFIG_LOG_DUMP_ASYNC
+
 //to be back compatible
 #define esp_log_buffer_hex		ESP_LOG_BUFFER_HEX
 #define esp_log_buffer_char		ESP_LOG_BUFFER_CHAR
@@ -240,14 +337,71 @@ void vSyslog(int Priority, const char * MsgID, const char * format, ...);
 
 // ######################## Common macros for BOOTLOADER+APP and DRAM logging ######################
 
+// count the variadic arguments of a log macro, used by the binary and ISR record capture paths
+#define _ESP_LOG_NARGS_SEQ(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, N, ...) N
+#define _ESP_LOG_NARGS(...) _ESP_LOG_NARGS_SEQ(0, ##__VA_ARGS__, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+
+#if CONFIG_LOG_BINARY_FORMAT && !defined(BOOTLOADER_BUILD)
+/* Binary record mode: the call site format string is interned into the dedicated
+ * .log_fmt flash section (placed via linker.lf) and only its address plus the raw
+ * 32-bit arguments go over the wire, decoded off-device by tools/log_decode.py */
+void esp_log_write_binary(esp_log_level_t level, const char* tag, const char* format, uint32_t nargs, ...);
+
+#define ESP_LOG_LEVEL(level, tag, format, ...) do {										\
+		static const char _log_fmt[] __attribute__((section(".log_fmt"))) = format;		\
+		esp_log_write_binary(level, tag, _log_fmt, _ESP_LOG_NARGS(__VA_ARGS__), ##__VA_ARGS__);\
+	} while(0)
+#else
 #define ESP_LOG_LEVEL(level, tag, format, ...) do {			\
 		esp_log_write(level, tag, format, ##__VA_ARGS__);	\
 	} while(0)
+#endif	// CONFIG_LOG_BINARY_FORMAT
+
+#if CONFIG_LOG_MODULE_IDS
+/* Numeric module-ID logging: components claim a compile-time small integer ID
+ * (their own enum, < CONFIG_LOG_MODULE_MAX) and register a display name once.
+ * The per-message gate is one uint8_t array load and a compare - no string
+ * handling at all. The string-tag path remains for third-party code. */
+extern uint8_t esp_log_module_levels[CONFIG_LOG_MODULE_MAX];
+
+int esp_log_module_register(unsigned id, const char* name);
+void esp_log_level_set_id(unsigned id, esp_log_level_t level);
+const char* esp_log_module_name(unsigned id);
+
+#define ESP_LOG_LEVEL_ID(level, id, format, ...) do {						\
+		if ((level) <= LOG_LOCAL_LEVEL &&									\
+			(esp_log_module_levels[id] >= (level))) {						\
+			esp_log_write(level, esp_log_module_name(id), format, ##__VA_ARGS__);\
+		}																	\
+	} while(0)
+#define ESP_LOGE_ID( id, format, ... ) ESP_LOG_LEVEL_ID(ESP_LOG_ERROR,   id, format, ##__VA_ARGS__)
+#define ESP_LOGW_ID( id, format, ... ) ESP_LOG_LEVEL_ID(ESP_LOG_WARN,    id, format, ##__VA_ARGS__)
+#define ESP_LOGI_ID( id, format, ... ) ESP_LOG_LEVEL_ID(ESP_LOG_INFO,    id, format, ##__VA_ARGS__)
+#define ESP_LOGD_ID( id, format, ... ) ESP_LOG_LEVEL_ID(ESP_LOG_DEBUG,   id, format, ##__VA_ARGS__)
+#define ESP_LOGV_ID( id, format, ... ) ESP_LOG_LEVEL_ID(ESP_LOG_VERBOSE, id, format, ##__VA_ARGS__)
+#endif	// CONFIG_LOG_MODULE_IDS
+
+#if CONFIG_LOG_ISR
+/* ISR-safe logging: claims a record from a static pool with a single atomic, captures
+ * the (scalar only, max 4) arguments raw and returns in ~100 cycles; formatting and
+ * sink output happen later in the deferred drain task. Pool exhaustion drops+counts. */
+void esp_log_write_isr(esp_log_level_t level, const char* tag, const char* format, uint32_t nargs, ...);
+
+#define ESP_LOG_ISR(level, tag, format, ...) do {												\
+		if ((level) <= LOG_LOCAL_LEVEL) {														\
+			esp_log_write_isr(level, tag, format, _ESP_LOG_NARGS(__VA_ARGS__), ##__VA_ARGS__);	\
+		}																						\
+	} while(0)
+#define ESP_LOGE_ISR( tag, format, ... ) ESP_LOG_ISR(ESP_LOG_ERROR,   tag, format, ##__VA_ARGS__)
+#define ESP_LOGW_ISR( tag, format, ... ) ESP_LOG_ISR(ESP_LOG_WARN,    tag, format, ##__VA_ARGS__)
+#define ESP_LOGI_ISR( tag, format, ... ) ESP_LOG_ISR(ESP_LOG_INFO,    tag, format, ##__VA_ARGS__)
+#endif	// CONFIG_LOG_ISR
 
 #define ESP_LOG_LEVEL_LOCAL(level, tag, format, ... ) do { 									\
 		if (level <= LOG_LOCAL_LEVEL) { ESP_LOG_LEVEL(level, tag, format, ## __VA_ARGS__); }\
 	} while(0)
 
+#undef _ESP_LOG_EARLY_ENABLED					// deliberate override of esp_log_level.h
 #ifdef BOOTLOADER_BUILD
 	#define _ESP_LOG_EARLY_ENABLED(log_level) (LOG_LOCAL_LEVEL >= (log_level))
 #else
@@ -257,6 +411,20 @@ void vSyslog(int Priority, const char * MsgID, const char * format, ...);
 #endif
 
 #define LOG_EARLY_FORMAT_STRING		"%d.%03d (%d) %d boot %s "
+#if CONFIG_LOG_BOOT_DEFER && !defined(BOOTLOADER_BUILD)
+/* Early output buffered in DRAM and replayed by the drain task once FreeRTOS runs,
+ * so boot is not throttled by console baud rate; falls back to synchronous
+ * esp_rom_printf once the buffer is full or replay has happened (see log_boot.c) */
+int esp_log_boot_capture(int level, const char* tag, const char* format, ...);
+#define ESP_LOG_EARLY_IMPL(tag, format, level, log_tag_letter, ...) do {									\
+		if (_ESP_LOG_EARLY_ENABLED(level) &&																\
+			!esp_log_boot_capture(level, tag, format, ##__VA_ARGS__)) {										\
+			uint32_t mS = esp_log_timestamp();																\
+			esp_rom_printf(LOG_EARLY_FORMAT_STRING, mS/1000, mS%1000, level, esp_cpu_get_core_id(), tag);	\
+			esp_rom_printf("" format "\n", ##__VA_ARGS__);													\
+		}																									\
+	} while(0)
+#else
 #define ESP_LOG_EARLY_IMPL(tag, format, level, log_tag_letter, ...) do {									\
 		if (_ESP_LOG_EARLY_ENABLED(level)) { 																\
 			uint32_t mS = esp_log_timestamp();																\
@@ -264,6 +432,7 @@ void vSyslog(int Priority, const char * MsgID, const char * format, ...);
 			esp_rom_printf("" format "\n", ##__VA_ARGS__);													\
 		}																									\
 	} while(0)
+#endif	// CONFIG_LOG_BOOT_DEFER
 
 #if defined(__cplusplus) && (__cplusplus >  201703L)
 	#define ESP_EARLY_LOGE( tag, format, ... ) ESP_LOG_EARLY_IMPL(tag, format, ESP_LOG_ERROR,   E __VA_OPT__(,) __VA_ARGS__)
@@ -0,0 +1,88 @@
+// esp_log_sink.h - multi-sink fan-out for formatted log records
+
+#pragma once
+
+#include <stddef.h>
+#include "esp_log_level.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Log output sink descriptor
+ *
+ * Each message is formatted once into a shared record and then offered by
+ * reference (zero-copy) to every registered sink whose min_level admits it.
+ * A sink owns its batching policy: write() may just queue/accumulate, with
+ * the periodic flush() callback (invoked from the log drain task, never from
+ * the producing task) doing the actual slow output, so one slow sink never
+ * backpressures the others.
+ */
+typedef struct esp_log_sink_t {
+	const char * name;								// short identifier, for diagnostics
+	esp_log_level_t min_level;						// only levels <= this are offered
+	void (*write)(void * ctx, int prio, const char * tag, const char * text, size_t len);
+	void (*flush)(void * ctx);						// optional, may be NULL
+	void * ctx;										// opaque, passed to write/flush
+} esp_log_sink_t;
+
+/**
+ * @brief Register an output sink
+ * @param psSink descriptor, copied; the ctx pointer must stay valid
+ * @return sink handle (>= 0) or -1 if the table (CONFIG_LOG_SINK_MAX) is full
+ */
+int esp_log_sink_register(const esp_log_sink_t * psSink);
+
+/**
+ * @brief Remove a previously registered sink
+ * @return 0 on success, -1 on invalid handle
+ */
+int esp_log_sink_unregister(int handle);
+
+/**
+ * @brief Change the minimum level admitted by a sink at runtime
+ */
+int esp_log_sink_set_level(int handle, esp_log_level_t level);
+
+#if CONFIG_LOG_SINK_FLASH
+#include <stdint.h>
+/**
+ * @brief Flash partition log store (log_flash.c): fixed-size segments used
+ *        round-robin (wear leveled) in the CONFIG_LOG_SINK_FLASH_PARTITION
+ *        data partition, with a RAM segment index for timestamp-range reads.
+ */
+int esp_log_sink_flash_start(esp_log_level_t min_level);
+void esp_log_sink_flash_stop(void);
+uint32_t esp_log_sink_flash_drops(void);
+
+/**
+ * @brief Retrieval callback: Text points zero-copy into the memory-mapped
+ *        partition, valid until the containing segment is recycled.
+ *        Return non-zero to stop the iteration.
+ */
+typedef int (*log_flash_read_cb_t)(void * Ctx, uint32_t TStamp, const char * Text, uint16_t Len);
+
+/**
+ * @brief Deliver every stored record with TsFrom <= timestamp <= TsTo (ms) in
+ *        chronological order; only segments whose index range overlaps are read
+ * @return records delivered, or -1 if the store is not mounted
+ */
+int esp_log_sink_flash_read(uint32_t TsFrom, uint32_t TsTo, log_flash_read_cb_t Cb, void * Ctx);
+#endif
+
+#if CONFIG_LOG_SINK_UDP
+/**
+ * @brief Start/stop forwarding to a UDP syslog collector (log_sink_udp.c)
+ *
+ * Lines are queued in a ring, coalesced into one datagram and sent from a
+ * dedicated task on a non-blocking socket; overflow drops oldest + counts.
+ */
+int esp_log_sink_udp_start(const char * host, uint16_t port, esp_log_level_t min_level);
+void esp_log_sink_udp_stop(void);
+uint32_t esp_log_sink_udp_drops(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,63 @@
+// esp_log_struct.h - structured key=value logging without printf capture cost
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_log_level.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Typed key-value pair captured by the ESP_SLOG macros
+ *
+ * Capture cost is a few stores per pair (no format string parsing, no printf);
+ * rendering to "key=value" text happens once in esp_slog_write() using small
+ * dedicated integer/string emitters, never the full printf machinery.
+ */
+typedef enum {
+	espKV_I32,
+	espKV_U32,
+	espKV_X32,										// rendered as 0x%08x
+	espKV_STR,
+} esp_log_kv_type_t;
+
+typedef struct esp_log_kv_t {
+	const char * key;
+	esp_log_kv_type_t type;
+	union {
+		int32_t i32;
+		uint32_t u32;
+		const char * str;
+	} v;
+} esp_log_kv_t;
+
+#define KV_I32(k, val)	((esp_log_kv_t) { .key = (k), .type = espKV_I32, .v.i32 = (val) })
+#define KV_U32(k, val)	((esp_log_kv_t) { .key = (k), .type = espKV_U32, .v.u32 = (val) })
+#define KV_X32(k, val)	((esp_log_kv_t) { .key = (k), .type = espKV_X32, .v.u32 = (val) })
+#define KV_STR(k, val)	((esp_log_kv_t) { .key = (k), .type = espKV_STR, .v.str = (val) })
+
+void esp_slog_write(esp_log_level_t level, const char * tag, uint32_t count, const esp_log_kv_t * kvs);
+
+/**
+ * @brief Structured logging entry points
+ *
+ * Usage: ESP_SLOGI(tag, KV_I32("rssi", rssi), KV_U32("vbat", mv), KV_STR("state", s));
+ * Output: "rssi=-63 vbat=3912 state=run" through the normal sink path.
+ */
+#define ESP_SLOG(level, tag, ...) do {													\
+		if ((level) <= LOG_LOCAL_LEVEL) {												\
+			const esp_log_kv_t _slog_kvs[] = { __VA_ARGS__ };							\
+			esp_slog_write(level, tag, sizeof(_slog_kvs) / sizeof(_slog_kvs[0]), _slog_kvs);\
+		}																				\
+	} while(0)
+
+#define ESP_SLOGE(tag, ...)	ESP_SLOG(ESP_LOG_ERROR, tag, __VA_ARGS__)
+#define ESP_SLOGW(tag, ...)	ESP_SLOG(ESP_LOG_WARN, tag, __VA_ARGS__)
+#define ESP_SLOGI(tag, ...)	ESP_SLOG(ESP_LOG_INFO, tag, __VA_ARGS__)
+#define ESP_SLOGD(tag, ...)	ESP_SLOG(ESP_LOG_DEBUG, tag, __VA_ARGS__)
+
+#ifdef __cplusplus
+}
+#endif
@@ -3,6 +3,9 @@
  * Copyright (c) 2017-24 Andre M. Maree / KSS Technologies (Pty) Ltd.
  */
 
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "esp_attr.h"
@@ -16,6 +19,8 @@
 #include "hal_platform.h"
 #include "string_general.h"
 
+#include "esp_log_private.h"
+
 // ########################################### Macros ##############################################
 
 #define	debugFLAG					(0xF000)
@@ -24,45 +29,387 @@
 #define	debugPARAM					(debugFLAG_GLOBAL & debugFLAG & 0x4000)
 #define	debugRESULT					(debugFLAG_GLOBAL & debugFLAG & 0x8000)
 
+#define	logTAG_HASH_SIZE			64				// open addressing slots, power of 2
+#define	logTAG_CACHE_SIZE			32				// direct mapped identity cache, power of 2
+#define	logTAG_PREFIX_SIZE			16				// compiled wildcard filter entries
+#define	logFMT_CACHE_SIZE			16				// format fixup memo entries, power of 2
+
+// format fixup decisions memoized per format-string pointer
+#define	logFMT_SHIFT				0x01			// wifi blob prefix, shift format + spill 2 args
+#define	logFMT_WIFI					0x02			// " %s:" or "%s", droppable when tag is wifi
+
+// ######################################## Structures #############################################
+
+typedef struct tag_level_t {
+	const char * Tag;								// heap copy, NULL = slot empty
+	uint8_t Level;
+} tag_level_t;
+
 // #################################### local/static variables #####################################
 
 esp_log_level_t esp_log_default_level = CONFIG_LOG_DEFAULT_LEVEL;
 
+uint8_t esp_log_in_panic = 0;						// set once by esp_log_panic_mode(), never cleared
+
+static tag_level_t sTagLevels[logTAG_HASH_SIZE];	// per-tag store, keyed by string
+static tag_level_t sTagCache[logTAG_CACHE_SIZE];	// fronting cache, keyed by pointer identity
+
+typedef struct tag_prefix_t {
+	const char * Prefix;							// heap copy, the trailing '*' stripped
+	uint8_t Len;
+	uint8_t Level;
+} tag_prefix_t;
+// wildcard patterns ("wifi*=W") compiled at esp_log_level_set() time into a flat
+// table sorted by descending prefix length, so the first scan hit is the longest
+// (most specific) match; consulted only on an identity cache miss
+static tag_prefix_t sPrefixes[logTAG_PREFIX_SIZE];
+static uint8_t sPrefixCount;
+
+typedef struct fmt_memo_t {
+	_Atomic uint32_t Seq;							// seqlock, odd while a writer is filling
+	const char * Fmt;								// call site format literal (cache key)
+	const char * NewFmt;							// format after prefix shift, or == Fmt
+	uint8_t Flags;									// logFMT_xxx
+} fmt_memo_t;
+static fmt_memo_t sFmtCache[logFMT_CACHE_SIZE];		// direct mapped, keyed by pointer identity
+static const char * sWifiTag = NULL;				// the wifi blob's static tag literal
+
 // ################################# forward function declarations #################################
 
 void xvSyslog(int Priority, const char * MsgID, const char * format, va_list args);
 
+// ##################################### private functions #########################################
+
+static uint32_t xLogTagHash(const char * tag) {
+	uint32_t Hash = 5381;							// djb2
+	while (*tag)
+		Hash = (Hash * 33) ^ *tag++;
+	return Hash;
+}
+
+/**
+ * @brief	Resolve the effective level for a tag, hot path.
+ *			Tag literals are static so the same pointer recurs for every message from a
+ *			call site; the identity cache makes the common case 2 loads and a compare,
+ *			falling back to the string-keyed hash only on a cache miss.
+ */
+static esp_log_level_t xLogTagLevel(const char * tag) {
+	if (tag == NULL)
+		return esp_log_default_level;
+	uint32_t Cx = ((uintptr_t) tag >> 2) & (logTAG_CACHE_SIZE - 1);
+	if (sTagCache[Cx].Tag == tag)
+		return sTagCache[Cx].Level;
+	esp_log_level_t Level = esp_log_default_level;
+	int Found = 0;
+	uint32_t Hx = xLogTagHash(tag);
+	for (int i = 0; i < logTAG_HASH_SIZE; ++i) {
+		tag_level_t * psTL = &sTagLevels[(Hx + i) & (logTAG_HASH_SIZE - 1)];
+		if (psTL->Tag == NULL)
+			break;									// probe chain end, tag not stored
+		if (strcmp(psTL->Tag, tag) == 0) {
+			Level = psTL->Level;
+			Found = 1;
+			break;
+		}
+	}
+	if (!Found) {									// exact entries outrank wildcard patterns
+		for (int i = 0; i < sPrefixCount; ++i) {
+			if (strncmp(sPrefixes[i].Prefix, tag, sPrefixes[i].Len) == 0) {
+				Level = sPrefixes[i].Level;
+				break;								// sorted longest first, first hit wins
+			}
+		}
+	}
+	sTagCache[Cx].Level = Level;
+	sTagCache[Cx].Tag = tag;						// publish pointer last
+	return Level;
+}
+
 // #################################### publi/global functions #####################################
 
-void esp_log_level_set(const char* tag, esp_log_level_t level) { esp_log_default_level = level; }
+/**
+ * @brief	Set the level for an exact tag or a wildcard pattern ("sensor_*").
+ *			Patterns are compiled here, not matched per message: the prefix is
+ *			stored in a table sorted by descending length and xLogTagLevel()
+ *			consults it only on an identity cache miss, so per-message cost is
+ *			unchanged however many filters are active. Terminal '*' only;
+ *			anything after the '*' is ignored. Exact entries outrank patterns.
+ */
+void esp_log_level_set(const char* tag, esp_log_level_t level) {
+	if (tag == NULL)
+		return;
+	esp_log_impl_lock();
+	const char * pcStar;
+	if (strcmp(tag, "*") == 0) {					// reset all tags to the given level
+		esp_log_default_level = level;
+		/* xLogTagLevel() reads these tables lock-free by design, strcmp'ing the
+		 * stored strings with no lock held, so freeing them here is a
+		 * use-after-free for a log call racing on the other core. Point every
+		 * entry at the new level instead: observable behaviour is identical
+		 * (everything resolves to the reset level until set again) and the
+		 * entries keep their table slots, a cost only near table capacity. */
+		for (int i = 0; i < logTAG_HASH_SIZE; ++i) {
+			if (sTagLevels[i].Tag)
+				sTagLevels[i].Level = level;
+		}
+		for (int i = 0; i < sPrefixCount; ++i)
+			sPrefixes[i].Level = level;
+	} else if ((pcStar = strchr(tag, '*')) != NULL) {	// wildcard, (re)compile the table
+		size_t Len = pcStar - tag;
+		int i;
+		for (i = 0; i < sPrefixCount; ++i) {
+			if (sPrefixes[i].Len == Len && strncmp(sPrefixes[i].Prefix, tag, Len) == 0) {
+				sPrefixes[i].Level = level;			// pattern already compiled
+				break;
+			}
+		}
+		if (i == sPrefixCount && Len && sPrefixCount < logTAG_PREFIX_SIZE) {
+			char * pcCopy = malloc(Len + 1);
+			if (pcCopy) {
+				memcpy(pcCopy, tag, Len);
+				pcCopy[Len] = 0;
+				while (i && sPrefixes[i - 1].Len < Len) {
+					sPrefixes[i] = sPrefixes[i - 1];	// keep descending length order
+					--i;
+				}
+				sPrefixes[i].Prefix = pcCopy;
+				sPrefixes[i].Len = Len;
+				sPrefixes[i].Level = level;
+				++sPrefixCount;
+			}
+		}											// table full: silently keep default
+	} else {
+		uint32_t Hx = xLogTagHash(tag);
+		for (int i = 0; i < logTAG_HASH_SIZE; ++i) {
+			tag_level_t * psTL = &sTagLevels[(Hx + i) & (logTAG_HASH_SIZE - 1)];
+			if (psTL->Tag == NULL) {
+				psTL->Tag = strdup(tag);
+				if (psTL->Tag)
+					psTL->Level = level;
+				break;
+			}
+			if (strcmp(psTL->Tag, tag) == 0) {
+				psTL->Level = level;
+				break;
+			}
+		}												// table full: silently keep default
+	}
+	memset(sTagCache, 0, sizeof(sTagCache));		// identity cache may hold stale levels
+	esp_log_impl_unlock();
+}
+
+esp_log_level_t esp_log_level_get(const char* tag) {
+	if (tag == NULL || strcmp(tag, "*") == 0)
+		return esp_log_default_level;
+	return xLogTagLevel(tag);
+}
+
+#if CONFIG_LOG_MODULE_IDS
+
+uint8_t esp_log_module_levels[CONFIG_LOG_MODULE_MAX];
+static const char * sModuleNames[CONFIG_LOG_MODULE_MAX];
+
+/**
+ * @brief	Claim a module ID (caller-owned enum value) and its display name
+ * @return	the id, or -1 if out of range / already claimed with another name
+ */
+int esp_log_module_register(unsigned id, const char * name) {
+	if (id >= CONFIG_LOG_MODULE_MAX || name == NULL)
+		return -1;
+	esp_log_impl_lock();
+	int iRV = (int) id;
+	if (sModuleNames[id] == NULL) {
+		sModuleNames[id] = name;
+		esp_log_module_levels[id] = esp_log_default_level;
+	} else if (strcmp(sModuleNames[id], name) != 0) {
+		iRV = -1;									// id collision between components
+	}
+	esp_log_impl_unlock();
+	return iRV;
+}
+
+void esp_log_level_set_id(unsigned id, esp_log_level_t level) {
+	if (id < CONFIG_LOG_MODULE_MAX)
+		esp_log_module_levels[id] = level;
+}
+
+const char * esp_log_module_name(unsigned id) {
+	const char * name = (id < CONFIG_LOG_MODULE_MAX) ? sModuleNames[id] : NULL;
+	return name ? name : "mod?";
+}
+
+#endif	// CONFIG_LOG_MODULE_IDS
 
 /* As of 20200323) wifi library changed format to 3 separate printf() calls
  * #1 "format="%c (%d) %s" and prints just the level, tag & timestamp hence just discard
  * #2 prints the actual message hence display as is
  * #3 format="%s" and prints CR/LF pair hence discard
  */
-void IRAM_ATTR esp_log_writev(esp_log_level_t level, const char* tag, const char * format, va_list args) {
+/* IRAM residency of esp_log_write/esp_log_writev is controlled by the placement
+ * profile in linker.lf (CONFIG_LOG_PLACEMENT_xxx), not hard-coded IRAM_ATTR */
+void esp_log_writev(esp_log_level_t level, const char* tag, const char * format, va_list args) {
+	#if CONFIG_LOG_DRAM_RING
+	if (level >= ESP_LOG_ERROR && level <= ESP_LOG_WARN && format)
+		vLogDramAppend(level, tag, format, args);	// unconditional, survives the panic handler
+	#endif
+	if (esp_log_in_panic) {							// last words: synchronous, lock and alloc free
+		if (level > xLogTagLevel(tag) || format == NULL)
+			return;
+		level += (level > 0) ? 2 : 0;
+		xvSyslog(level, tag, format, args);
+		return;
+	}
+	if (level > xLogTagLevel(tag))
+		return;										// silenced at runtime for this tag
+	#if CONFIG_LOG_STATS && !defined(BOOTLOADER_BUILD)
+	vLogStatsLevel(level);
+	#endif
 	if (format) {
-		void * pV = strstr(format, "%c (%d) %s:");
-		if (pV) {
-			format = pV + (sizeof("%c (%d)") - 1);
-			pV = va_arg(args, void *);					// spill tag (2nd copy)
+		/* Format strings are static literals so the same pointer recurs thousands of
+		 * times; the strstr + strcmp scans run once per literal and the decision is
+		 * memoized in a small direct-mapped cache keyed by pointer identity. Entries
+		 * are per-entry seqlocks (the s_ts64 pattern): two literals colliding on a
+		 * slot from different cores could otherwise publish one key with the other's
+		 * {NewFmt, Flags}, and a wrong logFMT_SHIFT spills two varargs that were
+		 * never passed. CAS losers use their locally computed decision uncached. */
+		fmt_memo_t * psM = &sFmtCache[((uintptr_t) format >> 2) & (logFMT_CACHE_SIZE - 1)];
+		uint32_t Seq = atomic_load(&psM->Seq);
+		uint8_t Flags;
+		const char * pccNew;
+		if (((Seq & 1) == 0) && psM->Fmt == format && atomic_load(&psM->Seq) == Seq) {
+			Flags = psM->Flags;							// consistent snapshot, torn read check
+			pccNew = psM->NewFmt;
+		} else {
+			Flags = 0;
+			pccNew = format;
+			char * pV = strstr(format, "%c (%d) %s:");
+			if (pV) {
+				Flags |= logFMT_SHIFT;
+				pccNew = pV + (sizeof("%c (%d)") - 1);
+			}
+			if ((strcmp(pccNew, " %s:") == 0) ||		// extra " wifi:"
+				(strcmp(pccNew, "%s") == 0))			// extra CRLF
+				Flags |= logFMT_WIFI;
+			if (((Seq & 1) == 0) && atomic_compare_exchange_strong(&psM->Seq, &Seq, Seq + 1)) {
+				psM->NewFmt = pccNew;
+				psM->Flags = Flags;
+				psM->Fmt = format;
+				atomic_store(&psM->Seq, Seq + 2);
+			}
+		}
+		if (Flags & logFMT_SHIFT) {
+			format = pccNew;
+			void * pV = va_arg(args, void *);			// spill tag (2nd copy)
+			(void) pV;
 			int xTS = va_arg(args, int);				// spill the timestamp
 			(void) xTS;
 		}
-		if ((strcmp(tag, "wifi") == 0) &&				// resolve WIFI lib anomalies
-		   ((strcmp(format, " %s:") == 0) ||			// remove extra " wifi:"
-			(strcmp(format, "%s") == 0))) {				// remove extra CRLF
-			return;
+		if (Flags & logFMT_WIFI) {						// resolve WIFI lib anomalies
+			if (tag == sWifiTag || strcmp(tag, "wifi") == 0) {
+				sWifiTag = tag;							// remember the blob's tag literal
+				return;
+			}
 		}
 	}
+	#if CONFIG_LOG_RATELIMIT
+	if (format && !xLogRateLimitCheck(level + ((level > 0) ? 2 : 0), tag, format))
+		return;										// flooding call site, counted + suppressed
+	#endif
+	#if CONFIG_LOG_BOOT_DEFER && !defined(BOOTLOADER_BUILD)
+	if (xLogBootCapture(level, tag, format, args))
+		return;										// pre-scheduler, buffered for replay
+	#endif
 	level += (level > 0) ? 2 : 0;
+	#if CONFIG_LOG_LINE_ASSEMBLY && !defined(BOOTLOADER_BUILD)
+	if (format && xLogLineAssemble(level, tag, format, args))
+		return;										// buffered (or emitted whole) per task
+	#endif
+	#if CONFIG_LOG_DEFERRED && !defined(BOOTLOADER_BUILD)
+	if (xLogDeferEnqueue(level, tag, format, args))
+		return;										// consumed by the lock-free ring
+	#endif
+	#if CONFIG_LOG_SINKS
+	char Text[CONFIG_LOG_SINK_REC_SIZE];			// sync fallback: format once, fan out
+	int Len = xLogFastFormat(Text, sizeof(Text), format, args);
+	if (Len < 0)
+		return;
+	if (Len >= (int) sizeof(Text))
+		Len = sizeof(Text) - 1;
+	vLogSinkDispatch(level, tag, Text, Len);
+	#else
 	xvSyslog(level, tag, format, args);
+	#endif
+}
+
+/**
+ * @brief	Output tail for records formatted outside esp_log_writev() (line
+ *			assembly, summaries): same defer / sink / syslog routing, priority
+ *			already syslog adjusted by the caller.
+ */
+void vLogTextEmit(int Priority, const char * MsgID, const char * Text) {
+	#if CONFIG_LOG_DEFERRED && !defined(BOOTLOADER_BUILD)
+	if (xLogDeferEnqueueText(Priority, MsgID, Text))
+		return;
+	#endif
+	#if CONFIG_LOG_SINKS
+	vLogSinkDispatch(Priority, MsgID, Text, strlen(Text));
+	#else
+	vSyslog(Priority, MsgID, "%s", Text);
+	#endif
+}
+
+/**
+ * @brief	Bulk output of text already rendered in the caller's buffer (see
+ *			esp_log_buffer_char_internal): the payload is dispatched by
+ *			reference in line-sized slices, no per-record formatting or
+ *			copying. Slices go through the same sink/syslog routing as every
+ *			other record - each emitter serializes itself, so slices from a
+ *			concurrent transfer can interleave, exactly as the equivalent
+ *			per-line ESP_LOG_LEVEL calls would. Slices are not NUL
+ *			terminated, every sink honours the length argument.
+ */
+void vLogBulkEmit(int level, const char * MsgID, const char * pcText, size_t Len) {
+	if (level > (int) xLogTagLevel(MsgID))
+		return;										// silenced at runtime for this tag
+	#if CONFIG_LOG_STATS && !defined(BOOTLOADER_BUILD)
+	vLogStatsLevel(level);
+	#endif
+	int Priority = level + ((level > 0) ? 2 : 0);
+	while (Len) {
+		const char * pcNL = memchr(pcText, '\n', Len);
+		size_t Slice = pcNL ? (size_t) (pcNL - pcText) : Len;
+		#if CONFIG_LOG_SINKS
+		vLogSinkDispatch(Priority, MsgID, pcText, Slice);
+		#else
+		vSyslog(Priority, MsgID, "%.*s", (int) Slice, pcText);
+		#endif
+		Slice += (pcNL != NULL);					// consume the newline, sinks frame themselves
+		pcText += Slice;
+		Len -= Slice;
+	}
 }
 
-void IRAM_ATTR esp_log_write(esp_log_level_t level, const char* tag, const char* format, ...) {
+void esp_log_write(esp_log_level_t level, const char* tag, const char* format, ...) {
 	va_list args;
 	va_start(args, format);
 	esp_log_writev(level, tag, format, args);
 	va_end(args);
 }
+
+/**
+ * @brief	Switch to the panic output path, called from the panic handler once
+ *			normal locking can no longer be trusted. Lock functions become
+ *			no-ops, producers stop enqueueing, records still sitting in the
+ *			deferred rings are flushed synchronously, and subsequent messages
+ *			go straight out. The entry and ring bookkeeping are IRAM resident
+ *			via linker.lf in every placement profile; emission itself funnels
+ *			into the sink dispatch / vSyslog tail which is not pinned here, so
+ *			rendered output still depends on the panic handler restoring the
+ *			flash cache before printing (which the IDF handler does).
+ */
+void esp_log_panic_mode(void) {
+	esp_log_in_panic = 1;
+	#if CONFIG_LOG_DEFERRED && !defined(BOOTLOADER_BUILD)
+	vLogDeferFlush();
+	#endif
+}
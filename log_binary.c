@@ -0,0 +1,77 @@
+/*
+ * log_binary.c - compact binary log record output (CONFIG_LOG_BINARY_FORMAT)
+ * Copyright (c) 2024 Andre M. Maree / KSS Technologies (Pty) Ltd.
+ *
+ * Instead of formatting text on the device, each ESP_LOGx call site interns
+ * its format string into the .log_fmt flash section (see linker.lf) and emits
+ * a fixed-layout binary record: format string address, level, tag address,
+ * timestamp and the raw 32-bit arguments. tools/log_decode.py recovers the
+ * strings from the application ELF and renders the original text on the host,
+ * cutting both UART bandwidth and on-device CPU by roughly 10x.
+ *
+ * Limitations: arguments are captured as 32-bit words, so 64-bit conversions
+ * (%lld / %llu) are not supported, and %s arguments only decode when they
+ * point at strings present in the ELF (literals), not runtime buffers.
+ */
+
+#include "sdkconfig.h"
+
+#if CONFIG_LOG_BINARY_FORMAT
+
+#include <stdio.h>
+
+#include "esp_log.h"
+#include "esp_log_private.h"
+
+// ########################################### Macros ##############################################
+
+#define	logBIN_SOF					0xA5			// start of frame marker
+#define	logBIN_MAX_ARGS				10
+
+// ######################################## Structures #############################################
+
+typedef struct __attribute__((packed)) log_bin_rec_t {
+	uint8_t SOF;
+	uint8_t Level;
+	uint8_t NumArgs;
+	uint8_t Check;									// XOR of all preceding+following bytes
+	uint32_t FmtAddr;
+	uint32_t TagAddr;
+	uint32_t TStamp;								// esp_log_timestamp() milliseconds
+	uint32_t Args[];								// NumArgs x 32-bit raw values
+} log_bin_rec_t;
+
+// #################################### public/global functions ####################################
+
+void esp_log_write_binary(esp_log_level_t level, const char * tag, const char * format, uint32_t nargs, ...) {
+	if (level > esp_log_level_get(tag))
+		return;										// esp_log_level_set() filtering as per text path
+	union {
+		log_bin_rec_t Rec;
+		uint8_t Buf[sizeof(log_bin_rec_t) + (logBIN_MAX_ARGS * sizeof(uint32_t))];
+	} U;
+	if (nargs > logBIN_MAX_ARGS)
+		nargs = logBIN_MAX_ARGS;
+	U.Rec.SOF = logBIN_SOF;
+	U.Rec.Level = level;
+	U.Rec.NumArgs = nargs;
+	U.Rec.Check = 0;
+	U.Rec.FmtAddr = (uint32_t) format;
+	U.Rec.TagAddr = (uint32_t) tag;
+	U.Rec.TStamp = esp_log_timestamp();
+	va_list args;
+	va_start(args, nargs);
+	for (uint32_t i = 0; i < nargs; ++i)
+		U.Rec.Args[i] = va_arg(args, uint32_t);
+	va_end(args);
+	size_t Size = sizeof(log_bin_rec_t) + (nargs * sizeof(uint32_t));
+	uint8_t Check = 0;
+	for (size_t i = 0; i < Size; ++i)
+		Check ^= U.Buf[i];
+	U.Rec.Check = Check;
+	esp_log_impl_lock();
+	fwrite(U.Buf, 1, Size, stdout);
+	esp_log_impl_unlock();
+}
+
+#endif	// CONFIG_LOG_BINARY_FORMAT
@@ -0,0 +1,106 @@
+/*
+ * log_boot.c - early-boot log capture, replayed once the scheduler runs
+ * Copyright (c) 2024 Andre M. Maree / KSS Technologies (Pty) Ltd.
+ *
+ * At 115200 baud the ~200 lines of a typical boot add ~150 ms of blocking
+ * FIFO writes before app_main. With CONFIG_LOG_BOOT_DEFER both the early
+ * (ESP_EARLY_LOGx) and normal pre-scheduler log paths append formatted text
+ * to a static DRAM buffer instead; the deferred drain task replays the
+ * buffer through the console once FreeRTOS is running. If the buffer fills
+ * the remainder of boot logging falls back to synchronous output, so
+ * nothing is ever lost silently.
+ */
+
+#include "sdkconfig.h"
+
+#if CONFIG_LOG_BOOT_DEFER
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_log_private.h"
+
+// ########################################### Macros ##############################################
+
+#define	logBOOT_BUF_SIZE			CONFIG_LOG_BOOT_DEFER_SIZE
+
+// #################################### local/static variables #####################################
+
+static char sBootBuf[logBOOT_BUF_SIZE];
+static uint32_t sBootLen = 0;
+static volatile uint8_t sBootDone = 0;				// set once replayed (or capture disabled)
+static portMUX_TYPE sBootMux = portMUX_INITIALIZER_UNLOCKED;
+
+// ##################################### private functions #########################################
+
+static int xLogBootAppend(int level, const char * tag, const char * format, va_list args) {
+	if (sBootDone || xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+		return 0;
+	portENTER_CRITICAL(&sBootMux);
+	uint32_t Avail = logBOOT_BUF_SIZE - sBootLen;
+	uint32_t mS = esp_log_early_timestamp();
+	int Hdr = snprintf(&sBootBuf[sBootLen], Avail, "%u.%03u (%d) %d boot %s ",
+			(unsigned) mS / 1000, (unsigned) mS % 1000, level, esp_cpu_get_core_id(), tag);
+	int Msg = -1;
+	if (Hdr >= 0 && Hdr < (int) Avail) {
+		va_list copy;								// caller reuses args on the sync fallback
+		va_copy(copy, args);
+		Msg = vsnprintf(&sBootBuf[sBootLen + Hdr], Avail - Hdr, format, copy);
+		va_end(copy);
+	}
+	int iRV = 0;
+	if (Hdr >= 0 && Msg >= 0 && (uint32_t) (Hdr + Msg + 1) < Avail) {
+		sBootLen += Hdr + Msg;
+		sBootBuf[sBootLen++] = '\n';
+		iRV = 1;
+	}											// else full: leave untouched, caller goes sync
+	portEXIT_CRITICAL(&sBootMux);
+	return iRV;
+}
+
+// #################################### public/global functions ####################################
+
+/**
+ * @brief	va_list capture entry used by esp_log_writev() before the scheduler runs
+ * @return	1 if captured, 0 if the caller must output synchronously
+ */
+int xLogBootCapture(int level, const char * tag, const char * format, va_list args) {
+	return xLogBootAppend(level, tag, format, args);
+}
+
+/**
+ * @brief	Variadic capture entry used by the ESP_EARLY_LOGx macros
+ */
+int esp_log_boot_capture(int level, const char * tag, const char * format, ...) {
+	va_list args;
+	va_start(args, format);
+	int iRV = xLogBootAppend(level, tag, format, args);
+	va_end(args);
+	return iRV;
+}
+
+/**
+ * @brief	Replay the captured boot log; called once by the deferred drain task.
+ *			Chunked so other tasks are not starved behind one long UART write.
+ */
+void vLogBootReplay(void) {
+	if (sBootDone)
+		return;
+	sBootDone = 1;									// stop further capture first
+	for (uint32_t Ofs = 0; Ofs < sBootLen; Ofs += 256) {
+		uint32_t Len = (sBootLen - Ofs > 256) ? 256 : sBootLen - Ofs;
+		esp_log_impl_lock();
+		fwrite(&sBootBuf[Ofs], 1, Len, stdout);
+		esp_log_impl_unlock();
+		vTaskDelay(1);								// yield between chunks
+	}
+	fflush(stdout);
+	sBootLen = 0;
+}
+
+#endif	// CONFIG_LOG_BOOT_DEFER
@@ -5,12 +5,52 @@
  */
 
 #include <ctype.h>
+#include <stdbool.h>
 #include <string.h>
 #include "esp_log.h"
+#include "esp_log_private.h" // vLogBulkEmit, the zero-copy bulk text path
+#if CONFIG_IDF_TARGET_LINUX
+// the whole host address space is byte accessible; lets these paths build,
+// run under sanitizers and benchmark on a workstation (see host_test/log_bench)
+static inline bool esp_ptr_byte_accessible(const void *ptr)
+{
+    (void) ptr;
+    return true;
+}
+#else
 #include "esp_memory_utils.h"
+#endif
 
 //print number of bytes per line for esp_log_buffer_char and esp_log_buffer_hex
 #define BYTES_PER_LINE 16
+//lines accumulated into one ESP_LOG_LEVEL (i.e. one lock round-trip) by the hex/hexdump dumpers
+#define LINES_PER_CHUNK 4
+
+//512-byte nibble-pair lookup table: s_hex_lut[b] holds the two ASCII hex chars of byte b
+static uint16_t s_hex_lut[256];
+
+static void hex_lut_init(void)
+{
+    static const char digits[] = "0123456789abcdef";
+    for (int i = 0; i < 256; i++) {
+        s_hex_lut[i] = (uint16_t)digits[i >> 4] | ((uint16_t)digits[i & 0x0f] << 8);
+    }
+}
+
+//encode len bytes as "xx " triplets in one pass, returns bytes written (3 per input byte).
+//dst needs 1 byte of slack beyond the triplets: each byte is emitted as one 32-bit store
+//(pair from the LUT plus the trailing space) which over-writes one byte ahead.
+static int encode_hex_line(char *dst, const char *src, int len)
+{
+    if (s_hex_lut[1] == 0) {
+        hex_lut_init();
+    }
+    for (int i = 0; i < len; i++) {
+        uint32_t v = s_hex_lut[(unsigned char)src[i]] | ((uint32_t)' ' << 16);
+        memcpy(dst + 3 * i, &v, sizeof(v)); //compiles to a single (unaligned-safe) word store
+    }
+    return 3 * len;
+}
 
 void esp_log_buffer_hex_internal(const char *tag, const void *buffer, uint16_t buff_len,
                                  esp_log_level_t log_level)
@@ -19,39 +59,71 @@ void esp_log_buffer_hex_internal(const char *tag, const void *buffer, uint16_t b
         return;
     }
     char temp_buffer[BYTES_PER_LINE + 3]; //for not-byte-accessible memory
-    char hex_buffer[3 * BYTES_PER_LINE + 1];
+    char hex_buffer[LINES_PER_CHUNK * (3 * BYTES_PER_LINE + 1) + 1];
     const char *ptr_line;
     int bytes_cur_line;
 
     do {
-        if (buff_len > BYTES_PER_LINE) {
-            bytes_cur_line = BYTES_PER_LINE;
-        } else {
-            bytes_cur_line = buff_len;
-        }
-        if (!esp_ptr_byte_accessible(buffer)) {
-            //use memcpy to get around alignment issue
-            memcpy(temp_buffer, buffer, (bytes_cur_line + 3) / 4 * 4);
-            ptr_line = temp_buffer;
-        } else {
-            ptr_line = buffer;
-        }
+        char *ptr_hex = hex_buffer;
+        int lines = 0;
+        do {
+            if (buff_len > BYTES_PER_LINE) {
+                bytes_cur_line = BYTES_PER_LINE;
+            } else {
+                bytes_cur_line = buff_len;
+            }
+            if (!esp_ptr_byte_accessible(buffer)) {
+                //use memcpy to get around alignment issue
+                memcpy(temp_buffer, buffer, (bytes_cur_line + 3) / 4 * 4);
+                ptr_line = temp_buffer;
+            } else {
+                ptr_line = buffer;
+            }
 
-        for (int i = 0; i < bytes_cur_line; i ++) {
-            sprintf(hex_buffer + 3 * i, "%02x ", ptr_line[i]);
-        }
+            if (ptr_hex != hex_buffer) {
+                ptr_hex[-1] = '\n'; //overwrite the previous line's trailing space
+            }
+            ptr_hex += encode_hex_line(ptr_hex, ptr_line, bytes_cur_line);
+            buffer += bytes_cur_line;
+            buff_len -= bytes_cur_line;
+        } while (buff_len && ++lines < LINES_PER_CHUNK);
+        *ptr_hex = 0;
         ESP_LOG_LEVEL(log_level, tag, "%s", hex_buffer);
-        buffer += bytes_cur_line;
-        buff_len -= bytes_cur_line;
     } while (buff_len);
 }
 
+//payloads at least this long are worth the printable pre-scan of the bulk path
+#define CHAR_BULK_MIN (BYTES_PER_LINE * 4)
+
+//printable text plus the usual transcript framing; anything else (binary data,
+//escape sequences) keeps the conservative line-by-line copying path
+static bool buffer_is_text(const char *ptr, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; i++) {
+        char c = ptr[i];
+        if (!isprint((int)(unsigned char)c) && c != '\n' && c != '\r' && c != '\t') {
+            return false;
+        }
+    }
+    return true;
+}
+
 void esp_log_buffer_char_internal(const char *tag, const void *buffer, uint16_t buff_len,
                                   esp_log_level_t log_level)
 {
     if (buff_len == 0) {
         return;
     }
+    //bulk zero-copy path: printable text in byte-accessible memory (multi-KB AT
+    //command / NMEA transcripts) goes through by reference in line-sized slices
+    //- no per-character sprintf, no 16-byte splitting, no copy into a scratch
+    //line. Level gating happens inside vLogBulkEmit, same runtime tag filter
+    //the ESP_LOG_LEVEL path below ends up in.
+    if (buff_len >= CHAR_BULK_MIN && esp_ptr_byte_accessible(buffer)
+            && buffer_is_text(buffer, buff_len)) {
+        vLogBulkEmit(log_level, tag, buffer, buff_len);
+        return;
+    }
     char temp_buffer[BYTES_PER_LINE + 3]; //for not-byte-accessible memory
     char char_buffer[BYTES_PER_LINE + 1];
     const char *ptr_line;
@@ -86,52 +158,64 @@ void esp_log_buffer_hexdump_internal(const char *tag, const void *buffer, uint16
     if (buff_len == 0) {
         return;
     }
+    if (s_hex_lut[1] == 0) {
+        hex_lut_init();
+    }
     char temp_buffer[BYTES_PER_LINE + 3]; //for not-byte-accessible memory
     const char *ptr_line;
     //format: field[length]
-    // ADDR[10]+"   "+DATA_HEX[8*3]+" "+DATA_HEX[8*3]+"  |"+DATA_CHAR[8]+"|"
-    char hd_buffer[10 + 3 + BYTES_PER_LINE * 3 + 3 + BYTES_PER_LINE + 1 + 1];
+    // ADDR["0x"+2 chars/byte]+"   "+DATA_HEX[8*3]+" "+DATA_HEX[8*3]+"  |"+DATA_CHAR[8]+"|"
+    char hd_buffer[LINES_PER_CHUNK * (2 + sizeof(void *) * 2 + 1 + 3 + BYTES_PER_LINE * 3 + 3 + BYTES_PER_LINE + 1 + 1 + 1)];
     char *ptr_hd;
     int bytes_cur_line;
 
     do {
-        if (buff_len > BYTES_PER_LINE) {
-            bytes_cur_line = BYTES_PER_LINE;
-        } else {
-            bytes_cur_line = buff_len;
-        }
-        if (!esp_ptr_byte_accessible(buffer)) {
-            //use memcpy to get around alignment issue
-            memcpy(temp_buffer, buffer, (bytes_cur_line + 3) / 4 * 4);
-            ptr_line = temp_buffer;
-        } else {
-            ptr_line = buffer;
-        }
         ptr_hd = hd_buffer;
-
-        ptr_hd += sprintf(ptr_hd, "%p ", buffer);
-        for (int i = 0; i < BYTES_PER_LINE; i ++) {
-            if ((i & 7) == 0) {
-                ptr_hd += sprintf(ptr_hd, " ");
-            }
-            if (i < bytes_cur_line) {
-                ptr_hd += sprintf(ptr_hd, " %02x", ptr_line[i]);
+        int lines = 0;
+        do {
+            if (buff_len > BYTES_PER_LINE) {
+                bytes_cur_line = BYTES_PER_LINE;
             } else {
-                ptr_hd += sprintf(ptr_hd, "   ");
+                bytes_cur_line = buff_len;
             }
-        }
-        ptr_hd += sprintf(ptr_hd, "  |");
-        for (int i = 0; i < bytes_cur_line; i ++) {
-            if (isprint((int)ptr_line[i])) {
-                ptr_hd += sprintf(ptr_hd, "%c", ptr_line[i]);
+            if (!esp_ptr_byte_accessible(buffer)) {
+                //use memcpy to get around alignment issue
+                memcpy(temp_buffer, buffer, (bytes_cur_line + 3) / 4 * 4);
+                ptr_line = temp_buffer;
             } else {
-                ptr_hd += sprintf(ptr_hd, ".");
+                ptr_line = buffer;
             }
-        }
-        ptr_hd += sprintf(ptr_hd, "|");
+            if (ptr_hd != hd_buffer) {
+                *ptr_hd++ = '\n';
+            }
+
+            ptr_hd += sprintf(ptr_hd, "%p ", buffer);
+            for (int i = 0; i < BYTES_PER_LINE; i ++) {
+                if ((i & 7) == 0) {
+                    *ptr_hd++ = ' ';
+                }
+                if (i < bytes_cur_line) {
+                    *ptr_hd++ = ' ';
+                    memcpy(ptr_hd, &s_hex_lut[(unsigned char)ptr_line[i]], 2);
+                    ptr_hd += 2;
+                } else {
+                    *ptr_hd++ = ' ';
+                    *ptr_hd++ = ' ';
+                    *ptr_hd++ = ' ';
+                }
+            }
+            *ptr_hd++ = ' ';
+            *ptr_hd++ = ' ';
+            *ptr_hd++ = '|';
+            for (int i = 0; i < bytes_cur_line; i ++) {
+                *ptr_hd++ = isprint((int)ptr_line[i]) ? ptr_line[i] : '.';
+            }
+            *ptr_hd++ = '|';
+            buffer += bytes_cur_line;
+            buff_len -= bytes_cur_line;
+        } while (buff_len && ++lines < LINES_PER_CHUNK);
+        *ptr_hd = 0;
 
         ESP_LOG_LEVEL(log_level, tag, "%s", hd_buffer);
-        buffer += bytes_cur_line;
-        buff_len -= bytes_cur_line;
     } while (buff_len);
 }
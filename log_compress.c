@@ -0,0 +1,147 @@
+/*
+ * log_compress.c - streaming LZSS compression stage for byte-stream log sinks
+ * Copyright (c) 2024 Andre M. Maree / KSS Technologies (Pty) Ltd.
+ *
+ * Heatshrink-class encoder: greedy LZSS over a static history window sized in
+ * Kconfig, bitstream of 1-bit flags, 8-bit literals and (W+L)-bit back
+ * references. Log text is highly repetitive (tags, timestamps, format bodies)
+ * and compresses 4-6x, so a flash-persisted sink gets proportionally more
+ * history per partition and fewer erase cycles for the same traffic.
+ *
+ * Byte-stream oriented, NOT record oriented: a storage sink feeds rendered
+ * records through vLogCompressWrite() and receives opaque compressed chunks on
+ * its output callback, batched into logCOMP_OUT_SIZE pieces so flash writes
+ * stay aligned-friendly. Single stream, caller serialized (the drain task in
+ * practice). Decode host-side with tools/log_decompress.py.
+ *
+ * Bitstream (MSB first): flag 1 = literal, 8 data bits follow;
+ * flag 0 = back reference, W bits (distance - 1) + L bits (length - 2).
+ */
+
+#include "sdkconfig.h"
+
+#if CONFIG_LOG_COMPRESS
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_log_private.h"
+
+// ########################################### Macros ##############################################
+
+#define	logCOMP_WIN_BITS			CONFIG_LOG_COMPRESS_WINDOW
+#define	logCOMP_LOOK_BITS			CONFIG_LOG_COMPRESS_LOOKAHEAD
+#define	logCOMP_WIN_SIZE			(1 << logCOMP_WIN_BITS)
+#define	logCOMP_MAX_MATCH			((1 << logCOMP_LOOK_BITS) + 1)	// length field holds len - 2
+#define	logCOMP_MIN_MATCH			2
+#define	logCOMP_OUT_SIZE			64				// compressed bytes per output callback
+
+// #################################### local/static variables #####################################
+
+static struct {
+	log_compress_out_t Out;							// receives compressed chunks
+	void * Ctx;
+	uint32_t WinLen;								// history bytes held, saturates at window size
+	uint32_t WinPos;								// ring write index
+	uint32_t BitBuf;								// pending bits, left aligned in the low byte(s)
+	uint8_t BitCnt;
+	uint8_t OutLen;
+	uint8_t OutBuf[logCOMP_OUT_SIZE];
+	uint8_t Window[logCOMP_WIN_SIZE];				// the static history window
+} sComp;
+
+// ##################################### private functions #########################################
+
+static void vLogCompPutBits(uint32_t Bits, int Count) {
+	sComp.BitBuf = (sComp.BitBuf << Count) | (Bits & ((1UL << Count) - 1));
+	sComp.BitCnt += Count;
+	while (sComp.BitCnt >= 8) {
+		sComp.BitCnt -= 8;
+		sComp.OutBuf[sComp.OutLen++] = (sComp.BitBuf >> sComp.BitCnt) & 0xFF;
+		if (sComp.OutLen == logCOMP_OUT_SIZE) {
+			sComp.Out(sComp.Ctx, sComp.OutBuf, sComp.OutLen);
+			sComp.OutLen = 0;
+		}
+	}
+}
+
+static void vLogCompPush(uint8_t Byte) {
+	sComp.Window[sComp.WinPos] = Byte;
+	sComp.WinPos = (sComp.WinPos + 1) & (logCOMP_WIN_SIZE - 1);
+	if (sComp.WinLen < logCOMP_WIN_SIZE)
+		++sComp.WinLen;
+}
+
+/**
+ * @brief	Longest window match for the bytes at pcData (Avail >= logCOMP_MIN_MATCH)
+ * @return	match length, 0 if below the threshold; *pDist = distance (1 based)
+ */
+static int xLogCompMatch(const uint8_t * pcData, int Avail, uint32_t * pDist) {
+	int Best = 0;
+	if (Avail > logCOMP_MAX_MATCH)
+		Avail = logCOMP_MAX_MATCH;
+	for (uint32_t Dist = 1; Dist <= sComp.WinLen; ++Dist) {
+		uint32_t Wx = (sComp.WinPos - Dist) & (logCOMP_WIN_SIZE - 1);
+		int Len = 0;
+		while (Len < Avail) {
+			// source may run past the window write point into bytes this very
+			// match produces; standard LZSS overlap, the decoder replays in order
+			uint8_t Ref = (Len < (int) Dist) ? sComp.Window[(Wx + Len) & (logCOMP_WIN_SIZE - 1)]
+											 : pcData[Len - Dist];
+			if (Ref != pcData[Len])
+				break;
+			++Len;
+		}
+		if (Len > Best) {
+			Best = Len;
+			*pDist = Dist;
+			if (Best == Avail)
+				break;
+		}
+	}
+	return (Best >= logCOMP_MIN_MATCH) ? Best : 0;
+}
+
+// #################################### public/global functions ####################################
+
+/**
+ * @brief	(Re)start the stream; prior window content and pending bits are discarded
+ */
+void vLogCompressInit(log_compress_out_t Out, void * Ctx) {
+	memset(&sComp, 0, sizeof(sComp));
+	sComp.Out = Out;
+	sComp.Ctx = Ctx;
+}
+
+void vLogCompressWrite(const uint8_t * pcData, size_t Len) {
+	for (size_t i = 0; i < Len; ) {
+		uint32_t Dist = 0;
+		int Match = ((Len - i) >= logCOMP_MIN_MATCH) ? xLogCompMatch(&pcData[i], Len - i, &Dist) : 0;
+		if (Match) {
+			vLogCompPutBits(0, 1);
+			vLogCompPutBits(Dist - 1, logCOMP_WIN_BITS);
+			vLogCompPutBits(Match - logCOMP_MIN_MATCH, logCOMP_LOOK_BITS);
+			while (Match--)
+				vLogCompPush(pcData[i++]);
+		} else {
+			vLogCompPutBits(1, 1);
+			vLogCompPutBits(pcData[i], 8);
+			vLogCompPush(pcData[i++]);
+		}
+	}
+}
+
+/**
+ * @brief	Push the batched complete bytes out to the sink.
+ *			Up to 7 bits stay pending (padding them mid-stream would corrupt the
+ *			bitstream); only a truncated trailing token is lost if the device
+ *			dies before the next write completes the byte.
+ */
+void vLogCompressFlush(void) {
+	if (sComp.OutLen) {
+		sComp.Out(sComp.Ctx, sComp.OutBuf, sComp.OutLen);
+		sComp.OutLen = 0;
+	}
+}
+
+#endif	// CONFIG_LOG_COMPRESS
@@ -0,0 +1,438 @@
+/*
+ * log_defer.c - lock-free deferred log output engine
+ * Copyright (c) 2024 Andre M. Maree / KSS Technologies (Pty) Ltd.
+ *
+ * Per-core MPSC ring buffers between the ESP_LOGx producers and a single low
+ * priority drain task. Producers claim a slot with one atomic add, format into
+ * it and mark it committed; no mutex is taken, nothing is shared cross-core on
+ * the produce side, and the producer never blocks. Every record is stamped
+ * with a global sequence number at commit time and the drain point merges the
+ * per-core streams by stamp, which keeps the interleaving of the cores close
+ * to real time. Ordering is approximate, not total: within one ring records
+ * drain in slot (claim) order, so a task preempted between claim and commit
+ * can emit an older stamp after a newer one from the same core. The drain
+ * task performs the actual (slow) sink output via vSyslog().
+ * If a ring is full the record is dropped and counted, never waited for.
+ */
+
+#include "sdkconfig.h"
+
+#if CONFIG_LOG_DEFERRED
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_compiler.h"
+#include "esp_log.h"
+#include "esp_log_private.h"
+
+// ########################################### Macros ##############################################
+
+#define	logDEFER_SLOT_SIZE			CONFIG_LOG_DEFERRED_SLOT_SIZE
+#define	logDEFER_SLOT_COUNT			CONFIG_LOG_DEFERRED_SLOT_COUNT
+#define	logDEFER_TASK_PRIO			CONFIG_LOG_DEFERRED_TASK_PRIO
+#define	logDEFER_TASK_STACK			3072
+#define	logDEFER_IDLE_TICKS			pdMS_TO_TICKS(100)
+
+// slot states
+#define	logSLOT_FREE				0
+#define	logSLOT_CLAIMED				1
+#define	logSLOT_COMMITTED			2
+
+#if CONFIG_LOG_ISR
+	#define	logISR_POOL_COUNT		CONFIG_LOG_ISR_POOL_COUNT
+	#define	logISR_MAX_ARGS			4
+#endif
+
+// ######################################## Structures #############################################
+
+typedef struct log_defer_rec_t {
+	_Atomic uint8_t State;							// logSLOT_{FREE,CLAIMED,COMMITTED}
+	uint8_t Prio;									// already syslog adjusted priority
+	uint16_t Len;
+	uint32_t Seq;									// global commit-order stamp, merge key
+	const char * Tag;								// static literal, stored by reference
+	char Text[logDEFER_SLOT_SIZE];
+} log_defer_rec_t;
+
+typedef struct log_defer_ring_t {
+	_Atomic uint32_t Head;							// next slot to claim (producers, same core)
+	uint32_t Tail;									// next slot to drain (drain task only)
+	_Atomic uint32_t Drops;							// records lost to a full ring
+	log_defer_rec_t Recs[logDEFER_SLOT_COUNT];
+} log_defer_ring_t;
+
+#if CONFIG_LOG_ISR
+typedef struct log_isr_rec_t {
+	_Atomic uint8_t State;
+	uint8_t Level;
+	uint8_t NumArgs;
+	const char * Tag;								// static literals, stored by reference
+	const char * Fmt;
+	uint32_t TStamp;								// esp_log_timestamp() at capture
+	uintptr_t Args[logISR_MAX_ARGS];				// raw scalar argument capture
+} log_isr_rec_t;
+#endif
+
+// #################################### local/static variables #####################################
+
+static log_defer_ring_t sRings[portNUM_PROCESSORS];
+static _Atomic uint32_t sSeqNum = 0;				// stamped at commit, the linearization point
+static TaskHandle_t sDrainTask = NULL;
+static _Atomic uint8_t sDrainStarted = 0;
+
+#if CONFIG_LOG_ISR
+static log_isr_rec_t sIsrPool[logISR_POOL_COUNT];
+static _Atomic uint32_t sIsrHead = 0;
+static uint32_t sIsrTail = 0;						// drain task only
+static _Atomic uint32_t sIsrDrops = 0;
+#endif
+
+#if CONFIG_LOG_DUMP_ASYNC
+typedef struct log_dump_snap_t {
+	_Atomic uint8_t State;
+	uint8_t Level;
+	uint8_t Truncated;
+	const char * Tag;								// static literal, stored by reference
+	uint16_t Len;									// snapshot length held in Data
+	uint16_t Done;									// bytes already emitted (drain task only)
+	uint8_t Data[CONFIG_LOG_DUMP_ASYNC_SNAP_SIZE];
+} log_dump_snap_t;
+
+#define	logDUMP_CHUNK				64				// bytes dumped per drain pass, for fairness
+
+static log_dump_snap_t sDumpPool[CONFIG_LOG_DUMP_ASYNC_POOL_COUNT];
+static _Atomic uint32_t sDumpHead = 0;
+static uint32_t sDumpTail = 0;						// drain task only
+#endif
+
+// ##################################### private functions #########################################
+
+/**
+ * @brief	Claim the slot at Head on the caller's ring, or drop+count when full.
+ *			Head only advances once the slot it points at has been seen FREE: an
+ *			unconditional fetch_add would move Head past undrained slots on every
+ *			full-ring drop, permanently desynchronising producers from the drain
+ *			point and stranding records behind a FREE slot. The state CAS after
+ *			winning the ticket arbitrates the (full-lap) race where another
+ *			producer wraps the entire ring between the two operations; the burned
+ *			ticket is harmless since the slot did get claimed and no slot is ever
+ *			skipped while FREE.
+ * @return	the claimed record, or NULL if the ring is full (drop counted)
+ */
+static log_defer_rec_t * psLogDeferClaim(log_defer_ring_t * psR) {
+	for (;;) {
+		uint32_t Head = atomic_load(&psR->Head);
+		log_defer_rec_t * psRec = &psR->Recs[Head % logDEFER_SLOT_COUNT];
+		if (atomic_load(&psRec->State) != logSLOT_FREE) {
+			atomic_fetch_add(&psR->Drops, 1);		// ring full, drop rather than block
+			return NULL;
+		}
+		if (!atomic_compare_exchange_strong(&psR->Head, &Head, Head + 1))
+			continue;								// lost the ticket race, reassess
+		uint8_t Expected = logSLOT_FREE;
+		if (atomic_compare_exchange_strong(&psRec->State, &Expected, logSLOT_CLAIMED))
+			return psRec;
+	}
+}
+
+static void vLogDeferEmit(int Prio, const char * Tag, const char * Text, size_t Len) {
+	#if CONFIG_LOG_SINKS
+	vLogSinkDispatch(Prio, Tag, Text, Len);
+	#else
+	vSyslog(Prio, Tag, "%s", Text);
+	#endif
+}
+
+/**
+ * @brief	Merge the per-core rings by commit stamp: of the committed head
+ *			records pick the lowest stamp, emit, repeat until all drained.
+ *			A claimed-but-uncommitted head is skipped, not waited for, and each
+ *			ring drains in slot order regardless of stamps, so the merge is
+ *			best-effort: if a producer is preempted between claiming a slot and
+ *			committing it, a later record from the same core (later slot, earlier
+ *			commit stamp) is emitted first. Accepted - waiting on an unfinished
+ *			slot would stall the whole drain behind one preempted producer.
+ */
+static void vLogDeferDrainRings(void) {
+	while (1) {
+		log_defer_ring_t * psBest = NULL;
+		log_defer_rec_t * psRec = NULL;
+		for (int i = 0; i < portNUM_PROCESSORS; ++i) {
+			log_defer_rec_t * psHead = &sRings[i].Recs[sRings[i].Tail % logDEFER_SLOT_COUNT];
+			if (atomic_load(&psHead->State) != logSLOT_COMMITTED)
+				continue;							// slot empty or still being formatted
+			if (psRec == NULL || (int32_t)(psHead->Seq - psRec->Seq) < 0) {
+				psBest = &sRings[i];				// wrap-safe signed stamp compare
+				psRec = psHead;
+			}
+		}
+		if (psRec == NULL)
+			break;
+		vLogDeferEmit(psRec->Prio, psRec->Tag, psRec->Text, psRec->Len);
+		atomic_store(&psRec->State, logSLOT_FREE);
+		++psBest->Tail;
+	}
+}
+
+#if CONFIG_LOG_ISR
+/**
+ * @brief	Format and emit committed ISR records, task context only.
+ *			The (max logISR_MAX_ARGS) arguments were captured raw as uintptr_t; passing
+ *			them back through a variadic call is valid for the scalar types supported.
+ *			Runtime tag filtering applies here rather than at capture, keeping the
+ *			ISR path free of table lookups; a silenced record costs one pool slot.
+ */
+static void vLogDeferDrainIsr(void) {
+	while (1) {
+		log_isr_rec_t * psRec = &sIsrPool[sIsrTail % logISR_POOL_COUNT];
+		if (atomic_load(&psRec->State) != logSLOT_COMMITTED)
+			break;
+		if (psRec->Level > esp_log_level_get(psRec->Tag)) {
+			atomic_store(&psRec->State, logSLOT_FREE);	// silenced at runtime, drop unformatted
+			++sIsrTail;
+			continue;
+		}
+		char Text[logDEFER_SLOT_SIZE + 20];
+		uintptr_t * pA = psRec->Args;
+		int Len = snprintf(Text, sizeof(Text), "[isr %u.%03u] ",
+				(unsigned) (psRec->TStamp / 1000), (unsigned) (psRec->TStamp % 1000));
+		Len += snprintf(Text + Len, sizeof(Text) - Len, psRec->Fmt, pA[0], pA[1], pA[2], pA[3]);
+		if (Len >= (int) sizeof(Text))
+			Len = sizeof(Text) - 1;
+		vLogDeferEmit(psRec->Level + 2, psRec->Tag, Text, Len);
+		atomic_store(&psRec->State, logSLOT_FREE);
+		++sIsrTail;
+	}
+}
+#endif
+
+#if CONFIG_LOG_DUMP_ASYNC
+/**
+ * @brief	Emit one chunk of the oldest pending snapshot per call so a multi-KB
+ *			dump interleaves fairly with normal messages instead of hogging output.
+ */
+static void vLogDumpDrainChunk(void) {
+	log_dump_snap_t * psS = &sDumpPool[sDumpTail % CONFIG_LOG_DUMP_ASYNC_POOL_COUNT];
+	if (atomic_load(&psS->State) != logSLOT_COMMITTED)
+		return;
+	uint16_t Len = psS->Len - psS->Done;
+	if (Len > logDUMP_CHUNK)
+		Len = logDUMP_CHUNK;
+	esp_log_buffer_hexdump_internal(psS->Tag, &psS->Data[psS->Done], Len, psS->Level);
+	psS->Done += Len;
+	if (psS->Done >= psS->Len) {
+		if (psS->Truncated)
+			vSyslog(psS->Level + 2, psS->Tag, "hexdump truncated to %u bytes", psS->Len);
+		atomic_store(&psS->State, logSLOT_FREE);
+		++sDumpTail;
+	}
+	if (atomic_load(&sDumpPool[sDumpTail % CONFIG_LOG_DUMP_ASYNC_POOL_COUNT].State) == logSLOT_COMMITTED)
+		xTaskNotifyGive(sDrainTask);				// more to do, keep the task awake
+}
+#endif
+
+static void vLogDeferTask(void * pvPara) {
+	#if CONFIG_LOG_BOOT_DEFER
+	vLogBootReplay();								// flush the captured boot log first
+	#endif
+	while (1) {
+		ulTaskNotifyTake(pdTRUE, logDEFER_IDLE_TICKS);
+		#if CONFIG_LOG_ISR
+		vLogDeferDrainIsr();						// ISR records first, usually most urgent
+		#endif
+		vLogDeferDrainRings();
+		#if CONFIG_LOG_DUMP_ASYNC
+		vLogDumpDrainChunk();
+		#endif
+		#if CONFIG_LOG_RATELIMIT
+		vLogRateLimitSweep();						// emit pending "repeated N times" summaries
+		#endif
+		#if CONFIG_LOG_LINE_ASSEMBLY
+		vLogLineSweep();							// flush partial lines idle past the timeout
+		#endif
+		#if CONFIG_LOG_STATS
+		vLogStatsReport();							// periodic pipeline health line
+		#endif
+		#if CONFIG_LOG_SINKS
+		vLogSinkFlushAll();							// let batching sinks run their flush policy
+		#endif
+	}
+}
+
+static void vLogDeferStart(void) {
+	uint8_t Expected = 0;
+	if (atomic_compare_exchange_strong(&sDrainStarted, &Expected, 1)) {
+		xTaskCreate(vLogDeferTask, "log_drain", logDEFER_TASK_STACK, NULL, logDEFER_TASK_PRIO, &sDrainTask);
+	}
+}
+
+// #################################### public/global functions ####################################
+
+/**
+ * @brief	Enqueue an already-formatted text record, same contract as xLogDeferEnqueue()
+ */
+int xLogDeferEnqueueText(int Priority, const char * MsgID, const char * Text) {
+	if (unlikely(esp_log_in_panic || xTaskGetSchedulerState() != taskSCHEDULER_RUNNING))
+		return 0;
+	if (unlikely(sDrainTask == NULL))
+		vLogDeferStart();
+	log_defer_rec_t * psRec = psLogDeferClaim(&sRings[xPortGetCoreID()]);
+	if (psRec == NULL)
+		return 1;									// ring full, dropped and counted
+	psRec->Prio = Priority;
+	psRec->Tag = MsgID;
+	size_t Len = strlen(Text);
+	if (Len >= logDEFER_SLOT_SIZE)
+		Len = logDEFER_SLOT_SIZE - 1;
+	memcpy(psRec->Text, Text, Len);
+	psRec->Text[Len] = 0;
+	psRec->Len = Len;
+	psRec->Seq = atomic_fetch_add(&sSeqNum, 1);
+	atomic_store(&psRec->State, logSLOT_COMMITTED);
+	if (sDrainTask && !xPortInIsrContext())
+		xTaskNotifyGive(sDrainTask);
+	return 1;
+}
+
+/**
+ * @brief	Enqueue a fully formatted copy of the message onto the calling core's ring
+ * @return	1 if the message was consumed (queued or deliberately dropped), 0 if the
+ *			caller must fall back to the synchronous output path
+ */
+int xLogDeferEnqueue(int Priority, const char * MsgID, const char * format, va_list args) {
+	if (unlikely(esp_log_in_panic || xTaskGetSchedulerState() != taskSCHEDULER_RUNNING))
+		return 0;									// early boot or panic, use sync path
+	if (unlikely(sDrainTask == NULL))
+		vLogDeferStart();
+	log_defer_rec_t * psRec = psLogDeferClaim(&sRings[xPortGetCoreID()]);
+	if (psRec == NULL)
+		return 1;									// ring full, dropped and counted
+	psRec->Prio = Priority;
+	psRec->Tag = MsgID;
+	int iRV = xLogFastFormat(psRec->Text, logDEFER_SLOT_SIZE, format, args);
+	psRec->Len = (iRV < 0) ? 0 : (iRV >= logDEFER_SLOT_SIZE) ? logDEFER_SLOT_SIZE - 1 : iRV;
+	psRec->Seq = atomic_fetch_add(&sSeqNum, 1);
+	atomic_store(&psRec->State, logSLOT_COMMITTED);
+	if (sDrainTask && !xPortInIsrContext())
+		xTaskNotifyGive(sDrainTask);
+	return 1;
+}
+
+#if CONFIG_LOG_ISR
+/**
+ * @brief	Bounded-time logging from any context, see ESP_LOG_ISR() in esp_log.h.
+ *			A short CAS loop to claim a pool record, a handful of stores to fill
+ *			it; never locks, never formats, never blocks. Exhausted pool drops+counts.
+ */
+void IRAM_ATTR esp_log_write_isr(esp_log_level_t level, const char * tag, const char * format, uint32_t nargs, ...) {
+	log_isr_rec_t * psRec;
+	for (;;) {										// same claim discipline as psLogDeferClaim()
+		uint32_t Slot = atomic_load(&sIsrHead);
+		psRec = &sIsrPool[Slot % logISR_POOL_COUNT];
+		if (atomic_load(&psRec->State) != logSLOT_FREE) {
+			atomic_fetch_add(&sIsrDrops, 1);		// pool exhausted, drop and count
+			return;
+		}
+		if (!atomic_compare_exchange_strong(&sIsrHead, &Slot, Slot + 1))
+			continue;								// lost the ticket race, reassess
+		uint8_t Expected = logSLOT_FREE;
+		if (atomic_compare_exchange_strong(&psRec->State, &Expected, logSLOT_CLAIMED))
+			break;
+	}
+	psRec->Level = level;
+	psRec->Tag = tag;
+	psRec->Fmt = format;
+	psRec->TStamp = esp_log_timestamp();
+	if (nargs > logISR_MAX_ARGS)
+		nargs = logISR_MAX_ARGS;
+	psRec->NumArgs = nargs;
+	va_list args;
+	va_start(args, nargs);
+	for (uint32_t i = 0; i < logISR_MAX_ARGS; ++i)
+		psRec->Args[i] = (i < nargs) ? va_arg(args, uintptr_t) : 0;
+	va_end(args);
+	atomic_store(&psRec->State, logSLOT_COMMITTED);
+	if (sDrainTask) {
+		if (xPortInIsrContext()) {
+			BaseType_t Woken = pdFALSE;
+			vTaskNotifyGiveFromISR(sDrainTask, &Woken);
+		} else {
+			xTaskNotifyGive(sDrainTask);
+		}
+	}
+}
+#endif	// CONFIG_LOG_ISR
+
+#if CONFIG_LOG_DUMP_ASYNC
+/**
+ * @brief	Asynchronous ESP_LOG_BUFFER_HEXDUMP: memcpy the buffer into a pooled
+ *			snapshot and return immediately; the drain task does the encoding and
+ *			interleaves the output with normal messages. Snapshots larger than the
+ *			pool slot, or arriving when the pool is exhausted, degrade to a
+ *			truncated dump - never to blocking the caller for the whole encode.
+ * @note	The address column shows snapshot offsets, not the original addresses.
+ */
+void esp_log_buffer_hexdump_async(const char * tag, const void * buffer, uint16_t buff_len, esp_log_level_t log_level) {
+	if (buff_len == 0)
+		return;
+	if (unlikely(esp_log_in_panic || xTaskGetSchedulerState() != taskSCHEDULER_RUNNING)) {
+		esp_log_buffer_hexdump_internal(tag, buffer, buff_len, log_level);
+		return;
+	}
+	if (unlikely(sDrainTask == NULL))
+		vLogDeferStart();
+	log_dump_snap_t * psS;
+	for (;;) {										// same claim discipline as psLogDeferClaim()
+		uint32_t Slot = atomic_load(&sDumpHead);
+		psS = &sDumpPool[Slot % CONFIG_LOG_DUMP_ASYNC_POOL_COUNT];
+		if (atomic_load(&psS->State) != logSLOT_FREE) {
+			// pool exhausted: bounded synchronous dump of the head, never a stall
+			esp_log_buffer_hexdump_internal(tag, buffer, (buff_len > logDUMP_CHUNK) ? logDUMP_CHUNK : buff_len, log_level);
+			if (buff_len > logDUMP_CHUNK)
+				vSyslog(log_level + 2, tag, "hexdump truncated to %u bytes (pool exhausted)", logDUMP_CHUNK);
+			return;
+		}
+		if (!atomic_compare_exchange_strong(&sDumpHead, &Slot, Slot + 1))
+			continue;								// lost the ticket race, reassess
+		uint8_t Expected = logSLOT_FREE;
+		if (atomic_compare_exchange_strong(&psS->State, &Expected, logSLOT_CLAIMED))
+			break;
+	}
+	psS->Truncated = (buff_len > CONFIG_LOG_DUMP_ASYNC_SNAP_SIZE);
+	psS->Len = psS->Truncated ? CONFIG_LOG_DUMP_ASYNC_SNAP_SIZE : buff_len;
+	psS->Done = 0;
+	psS->Tag = tag;
+	psS->Level = log_level;
+	memcpy(psS->Data, buffer, psS->Len);
+	atomic_store(&psS->State, logSLOT_COMMITTED);
+	xTaskNotifyGive(sDrainTask);
+}
+#endif	// CONFIG_LOG_DUMP_ASYNC
+
+/**
+ * @brief	Synchronously drain all rings from the calling context.
+ *			Intended for shutdown / flush points, not the normal output path.
+ */
+void vLogDeferFlush(void) {
+	#if CONFIG_LOG_ISR
+	vLogDeferDrainIsr();
+	#endif
+	vLogDeferDrainRings();
+}
+
+uint32_t ulLogDeferDropCount(void) {
+	uint32_t Total = 0;
+	for (int i = 0; i < portNUM_PROCESSORS; ++i)
+		Total += atomic_load(&sRings[i].Drops);
+	#if CONFIG_LOG_ISR
+	Total += atomic_load(&sIsrDrops);
+	#endif
+	return Total;
+}
+
+#endif	// CONFIG_LOG_DEFERRED
@@ -0,0 +1,79 @@
+/*
+ * log_dram.c - always-on crash-safe DRAM ring of recent WARN+ log records
+ * Copyright (c) 2024 Andre M. Maree / KSS Technologies (Pty) Ltd.
+ *
+ * Every WARN or ERROR passing through esp_log_writev() is also appended here
+ * as a compact reference record (cycle count, level, tag/format pointers and
+ * the first two raw arguments) regardless of whether any sink is active. The
+ * ring lives in DRAM under a well-known magic so coredump tooling can locate
+ * it via the esp_log_dram_ring symbol (or by scanning for the magic) and
+ * reconstruct the final messages leading up to a panic, with the strings
+ * themselves recovered from the application ELF.
+ *
+ * The append path is lock-free and a handful of instructions, IRAM resident
+ * via linker.lf, so it stays essentially free and works with flash cache off.
+ */
+
+#include "sdkconfig.h"
+
+#if CONFIG_LOG_DRAM_RING
+
+#include <stdatomic.h>
+
+#include "esp_attr.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "esp_log_private.h"
+
+// ########################################### Macros ##############################################
+
+#define	logDRAM_MAGIC				0x4C52444CUL	// "LDRL"
+#define	logDRAM_REC_COUNT			CONFIG_LOG_DRAM_RING_COUNT
+
+// ######################################## Structures #############################################
+
+typedef struct log_dram_rec_t {
+	uint32_t Cycles;								// esp_cpu_get_cycle_count() at append
+	const char * Tag;								// static literal, resolve via ELF
+	const char * Fmt;								// static literal, resolve via ELF
+	uintptr_t Args[2];								// first two raw arguments (may be garbage
+	uint8_t Level;									//   padding if the call site passed fewer)
+	uint8_t Spare[3];
+} log_dram_rec_t;
+
+typedef struct log_dram_ring_t {
+	uint32_t Magic;
+	uint32_t Count;									// logDRAM_REC_COUNT, for the extractor
+	_Atomic uint32_t Head;							// total appends, next slot = Head % Count
+	log_dram_rec_t Recs[logDRAM_REC_COUNT];
+} log_dram_ring_t;
+
+// #################################### local/static variables #####################################
+
+// global (not static) so the symbol is visible to coredump extraction tooling
+log_dram_ring_t esp_log_dram_ring = { .Magic = logDRAM_MAGIC, .Count = logDRAM_REC_COUNT };
+
+// #################################### public/global functions ####################################
+
+// IRAM residency controlled by the placement profile in linker.lf
+void vLogDramAppend(uint8_t Level, const char * Tag, const char * Fmt, va_list Args) {
+	uint32_t Slot = atomic_fetch_add(&esp_log_dram_ring.Head, 1) % logDRAM_REC_COUNT;
+	log_dram_rec_t * psRec = &esp_log_dram_ring.Recs[Slot];
+	psRec->Cycles = esp_cpu_get_cycle_count();
+	psRec->Level = Level;
+	psRec->Tag = Tag;
+	psRec->Fmt = Fmt;
+	va_list Copy;									// peek, the caller still owns Args
+	va_copy(Copy, Args);
+	psRec->Args[0] = va_arg(Copy, uintptr_t);
+	psRec->Args[1] = va_arg(Copy, uintptr_t);
+	va_end(Copy);
+}
+
+const void * pvLogDramRing(uint32_t * pCount) {
+	if (pCount)
+		*pCount = logDRAM_REC_COUNT;
+	return &esp_log_dram_ring;
+}
+
+#endif	// CONFIG_LOG_DRAM_RING
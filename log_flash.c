@@ -0,0 +1,336 @@
+/*
+ * log_flash.c - wear-leveled flash partition log store with indexed retrieval
+ * Copyright (c) 2024 Andre M. Maree / KSS Technologies (Pty) Ltd.
+ *
+ * Persists the formatted record stream into a dedicated data partition for
+ * field units that are offline for days. The partition is divided into
+ * fixed-size segments (one erase sector by default) used round-robin, which
+ * spreads erase cycles evenly over the partition - the wear leveling needs no
+ * separate allocation map. Each segment starts with a small header (monotonic
+ * sequence number, first/last record timestamps); mounted headers are mirrored
+ * into a RAM index so a timestamp-range retrieval touches only the segments
+ * that can contain matching records, never scanning the whole partition.
+ *
+ * Appends batch in RAM (CONFIG_LOG_SINK_FLASH_BATCH) and hit flash in chunks;
+ * reads go through the memory-mapped flash window so retrieval hands out
+ * zero-copy pointers into the partition - no staging buffer needed beyond the
+ * caller's framing. Mounting always opens a fresh segment rather than
+ * resuming a partial one; the interrupted segment stays readable as-is.
+ * Flash-encrypted partitions are not supported (byte-granular writes).
+ * With CONFIG_LOG_SINK_FLASH_COMPRESS the batch stream runs through the LZSS
+ * stage (log_compress.c) on its way to flash, one self-contained stream per
+ * segment: 4-6x more history per partition, at the cost of record-level
+ * retrieval - compressed segments are decoded host-side (log_decompress.py),
+ * esp_log_sink_flash_read() is unavailable. Segment headers stay uncompressed
+ * so the timestamp index keeps working for host-side extraction.
+ */
+
+#include "sdkconfig.h"
+
+#if CONFIG_LOG_SINK_FLASH
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "esp_log.h"
+#include "esp_log_sink.h"
+#include "esp_log_private.h"
+#include "esp_partition.h"
+
+// ########################################### Macros ##############################################
+
+#define	logFLASH_MAGIC				0x53474F4CUL	// "LOGS"
+#define	logFLASH_SEG_SIZE			CONFIG_LOG_SINK_FLASH_SEG_SIZE
+#define	logFLASH_BATCH_SIZE			CONFIG_LOG_SINK_FLASH_BATCH
+#define	logFLASH_TS_OPEN			0xFFFFFFFFUL	// timestamp field still erased
+#define	logFLASH_LEN_FREE			0xFFFF			// record length field still erased
+
+// ######################################## Structures #############################################
+
+typedef struct log_flash_hdr_t {					// segment header, written in place
+	uint32_t Magic;
+	uint32_t Seq;									// monotonic allocation number
+	uint32_t TsFirst;								// ms timestamp of the first record
+	uint32_t TsLast;								// written at close, erased while open
+} log_flash_hdr_t;
+
+typedef struct log_flash_rec_t {					// record header, text follows
+	uint16_t Len;									// text bytes, logFLASH_LEN_FREE = end
+	uint16_t Inv;									// ~Len, cheap corruption check
+	uint32_t TStamp;								// esp_log_timestamp() at append
+} log_flash_rec_t;
+
+typedef struct log_flash_idx_t {					// RAM mirror of one segment header
+	uint32_t Seq;									// 0 = segment empty / unreadable
+	uint32_t TsFirst;
+	uint32_t TsLast;								// logFLASH_TS_OPEN if never closed
+} log_flash_idx_t;
+
+// #################################### local/static variables #####################################
+
+static struct {
+	const esp_partition_t * psPart;
+	const uint8_t * pcMap;							// memory-mapped partition window
+	esp_partition_mmap_handle_t MapHdl;
+	SemaphoreHandle_t Mutex;
+	log_flash_idx_t * psIdx;						// one entry per segment
+	uint32_t SegCount;
+	uint32_t CurSeg;								// segment being appended to
+	uint32_t CurOfs;								// next write offset within CurSeg
+	uint32_t Seq;									// Seq of CurSeg
+	uint32_t Drops;									// records lost (no store / open failed)
+	uint16_t BatchLen;
+	int Handle;										// sink registry handle
+	char Batch[logFLASH_BATCH_SIZE];
+} sFS = { .Handle = -1 };
+
+// ##################################### private functions #########################################
+
+static uint32_t xLogFlashSegBase(uint32_t Seg) { return Seg * logFLASH_SEG_SIZE; }
+
+#if CONFIG_LOG_SINK_FLASH_COMPRESS
+/**
+ * @brief	Compressed-chunk consumer: appends encoder output at the write point.
+ *			The clamp is a backstop only - the rotation reserve in vLogFlashWrite()
+ *			covers worst-case LZSS expansion, so a chunk should always fit.
+ */
+static void vLogFlashCompOut(void * Ctx, const uint8_t * pcData, size_t Len) {
+	(void) Ctx;
+	if (sFS.CurOfs + Len > logFLASH_SEG_SIZE)
+		Len = logFLASH_SEG_SIZE - sFS.CurOfs;
+	if (Len == 0)
+		return;
+	esp_partition_write(sFS.psPart, xLogFlashSegBase(sFS.CurSeg) + sFS.CurOfs, pcData, Len);
+	sFS.CurOfs += Len;
+}
+#endif
+
+/**
+ * @brief	Push the RAM batch to flash at the current append point.
+ *			Compressed builds feed the encoder instead; its output callback
+ *			does the partition writes and advances the write point.
+ */
+static void vLogFlashBatchWrite(void) {
+	if (sFS.BatchLen == 0)
+		return;
+	#if CONFIG_LOG_SINK_FLASH_COMPRESS
+	vLogCompressWrite((const uint8_t *) sFS.Batch, sFS.BatchLen);
+	#else
+	esp_partition_write(sFS.psPart, xLogFlashSegBase(sFS.CurSeg) + sFS.CurOfs, sFS.Batch, sFS.BatchLen);
+	sFS.CurOfs += sFS.BatchLen;
+	#endif
+	sFS.BatchLen = 0;
+}
+
+/**
+ * @brief	Erase a segment and start appending to it: write a fresh header
+ *			with the next sequence number, mirror it into the RAM index
+ */
+static int xLogFlashOpenSeg(uint32_t Seg) {
+	if (esp_partition_erase_range(sFS.psPart, xLogFlashSegBase(Seg), logFLASH_SEG_SIZE) != ESP_OK)
+		return 0;
+	log_flash_hdr_t sHdr = { logFLASH_MAGIC, sFS.Seq + 1, logFLASH_TS_OPEN, logFLASH_TS_OPEN };
+	if (esp_partition_write(sFS.psPart, xLogFlashSegBase(Seg), &sHdr, sizeof(sHdr)) != ESP_OK)
+		return 0;
+	++sFS.Seq;
+	sFS.CurSeg = Seg;
+	sFS.CurOfs = sizeof(log_flash_hdr_t);
+	sFS.psIdx[Seg].Seq = sFS.Seq;
+	sFS.psIdx[Seg].TsFirst = logFLASH_TS_OPEN;
+	sFS.psIdx[Seg].TsLast = logFLASH_TS_OPEN;
+	#if CONFIG_LOG_SINK_FLASH_COMPRESS
+	vLogCompressInit(vLogFlashCompOut, NULL);		// fresh stream: every segment decodes alone
+	#endif
+	return 1;
+}
+
+/**
+ * @brief	Close the active segment (write TsLast) and open the next one.
+ *			Round-robin rotation doubles as wear leveling - every sector
+ *			erases at the same rate, no separate allocation map needed.
+ */
+static int xLogFlashRotate(uint32_t TsNow) {
+	vLogFlashBatchWrite();
+	#if CONFIG_LOG_SINK_FLASH_COMPRESS
+	vLogCompressFlush();							// complete the segment's stream
+	#endif
+	esp_partition_write(sFS.psPart, xLogFlashSegBase(sFS.CurSeg) + offsetof(log_flash_hdr_t, TsLast), &TsNow, sizeof(TsNow));
+	sFS.psIdx[sFS.CurSeg].TsLast = TsNow;
+	return xLogFlashOpenSeg((sFS.CurSeg + 1) % sFS.SegCount);
+}
+
+static void vLogFlashWrite(void * Ctx, int Prio, const char * Tag, const char * Text, size_t Len) {
+	(void) Ctx;
+	char Rendered[logFLASH_BATCH_SIZE];
+	uint32_t TsNow = esp_log_timestamp();
+	int rLen = snprintf(Rendered, sizeof(Rendered) - sizeof(log_flash_rec_t), "<%d>%s %.*s", Prio, Tag, (int) Len, Text);
+	if (rLen < 0)
+		return;
+	if (rLen >= (int) (sizeof(Rendered) - sizeof(log_flash_rec_t)))
+		rLen = sizeof(Rendered) - sizeof(log_flash_rec_t) - 1;
+	uint32_t Need = sizeof(log_flash_rec_t) + ((rLen + 3) & ~3);	// keep 32-bit alignment
+	xSemaphoreTake(sFS.Mutex, portMAX_DELAY);
+	uint32_t Pend = sFS.BatchLen + Need;
+	#if CONFIG_LOG_SINK_FLASH_COMPRESS
+	// worst case LZSS expansion is 9 bits per literal, plus one output chunk
+	// still batched inside the encoder; reserve for it so the stream never
+	// gets cut off at the segment end mid-token
+	Pend += Pend / 8 + 66;
+	#endif
+	if (sFS.CurOfs + Pend > logFLASH_SEG_SIZE) {
+		if (!xLogFlashRotate(TsNow)) {
+			++sFS.Drops;
+			xSemaphoreGive(sFS.Mutex);
+			return;
+		}
+	}
+	if (sFS.BatchLen + Need > logFLASH_BATCH_SIZE)
+		vLogFlashBatchWrite();
+	log_flash_rec_t sRec = { rLen, (uint16_t) ~rLen, TsNow };
+	memcpy(&sFS.Batch[sFS.BatchLen], &sRec, sizeof(sRec));
+	memset(&sFS.Batch[sFS.BatchLen + sizeof(sRec)], 0xFF, Need - sizeof(sRec));
+	memcpy(&sFS.Batch[sFS.BatchLen + sizeof(sRec)], Rendered, rLen);
+	sFS.BatchLen += Need;
+	if (sFS.psIdx[sFS.CurSeg].TsFirst == logFLASH_TS_OPEN) {		// first record of the segment
+		esp_partition_write(sFS.psPart, xLogFlashSegBase(sFS.CurSeg) + offsetof(log_flash_hdr_t, TsFirst), &TsNow, sizeof(TsNow));
+		sFS.psIdx[sFS.CurSeg].TsFirst = TsNow;
+	}
+	xSemaphoreGive(sFS.Mutex);
+}
+
+static void vLogFlashFlush(void * Ctx) {
+	(void) Ctx;
+	xSemaphoreTake(sFS.Mutex, portMAX_DELAY);
+	vLogFlashBatchWrite();
+	#if CONFIG_LOG_SINK_FLASH_COMPRESS
+	vLogCompressFlush();							// up to 7 bits stay pending, see log_compress.c
+	#endif
+	xSemaphoreGive(sFS.Mutex);
+}
+
+// #################################### public/global functions ####################################
+
+/**
+ * @brief	Mount the store and register it as a sink.
+ *			Builds the RAM segment index from the mapped headers, then opens a
+ *			fresh segment after the highest sequence number found.
+ * @return	0 on success, -1 (no partition / mmap / erase failure / registry full)
+ */
+int esp_log_sink_flash_start(esp_log_level_t min_level) {
+	if (sFS.Handle >= 0)
+		return 0;									// already mounted
+	sFS.psPart = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, CONFIG_LOG_SINK_FLASH_PARTITION);
+	if (sFS.psPart == NULL)
+		return -1;
+	if (esp_partition_mmap(sFS.psPart, 0, sFS.psPart->size, ESP_PARTITION_MMAP_DATA, (const void **) &sFS.pcMap, &sFS.MapHdl) != ESP_OK)
+		return -1;
+	sFS.SegCount = sFS.psPart->size / logFLASH_SEG_SIZE;
+	sFS.psIdx = calloc(sFS.SegCount, sizeof(log_flash_idx_t));
+	if (sFS.psIdx == NULL || (sFS.Mutex = xSemaphoreCreateMutex()) == NULL)
+		return -1;
+	uint32_t HiSeq = 0, HiSeg = 0;
+	for (uint32_t i = 0; i < sFS.SegCount; ++i) {	// index existing segments
+		const log_flash_hdr_t * psHdr = (const log_flash_hdr_t *) &sFS.pcMap[xLogFlashSegBase(i)];
+		if (psHdr->Magic != logFLASH_MAGIC)
+			continue;
+		sFS.psIdx[i].Seq = psHdr->Seq;
+		sFS.psIdx[i].TsFirst = psHdr->TsFirst;
+		sFS.psIdx[i].TsLast = psHdr->TsLast;
+		if (psHdr->Seq > HiSeq) {
+			HiSeq = psHdr->Seq;
+			HiSeg = i;
+		}
+	}
+	sFS.Seq = HiSeq;
+	// never resume the interrupted segment: open a fresh one after it (the
+	// partial one stays readable, its open-range TsLast covering the gap)
+	if (!xLogFlashOpenSeg(HiSeq ? (HiSeg + 1) % sFS.SegCount : 0))
+		return -1;
+	esp_log_sink_t sSink = { "flash", min_level, vLogFlashWrite, vLogFlashFlush, NULL };
+	sFS.Handle = esp_log_sink_register(&sSink);
+	return (sFS.Handle >= 0) ? 0 : -1;
+}
+
+/**
+ * @brief	Flush and unregister; the mapping stays so reads keep working
+ */
+void esp_log_sink_flash_stop(void) {
+	if (sFS.Handle < 0)
+		return;
+	vLogFlashFlush(NULL);
+	esp_log_sink_unregister(sFS.Handle);
+	sFS.Handle = -1;
+}
+
+uint32_t esp_log_sink_flash_drops(void) { return sFS.Drops; }
+
+/**
+ * @brief	Timestamp-range retrieval via the RAM index and the mapped window.
+ *			Segments are visited in sequence (chronological) order; segments
+ *			whose [TsFirst,TsLast] cannot overlap the range are skipped without
+ *			touching flash. Text pointers handed to the callback reference the
+ *			mapped partition directly - valid until the segment is recycled,
+ *			so consume or copy within the callback.
+ *			Unavailable on compressed stores: segments hold an opaque LZSS
+ *			bitstream, retrieval there is host-side via log_decompress.py.
+ * @return	records delivered, or -1 if the store is not mounted (or compressed)
+ */
+int esp_log_sink_flash_read(uint32_t TsFrom, uint32_t TsTo, log_flash_read_cb_t Cb, void * Ctx) {
+	#if CONFIG_LOG_SINK_FLASH_COMPRESS
+	(void) TsFrom; (void) TsTo; (void) Cb; (void) Ctx;
+	return -1;
+	#else
+	if (sFS.pcMap == NULL)
+		return -1;
+	int Count = 0;
+	/* Visit segments in ascending Seq (chronological) order by selecting the
+	 * smallest Seq above the previous pass each time: O(SegCount^2) index scans
+	 * but zero stack - a VLA sized by SegCount grows with the partition (4 KB
+	 * for a 4 MB store), far too much for a caller's task stack. */
+	uint32_t PrevSeq = 0;
+	for (;;) {
+		uint32_t Seg = sFS.SegCount;
+		uint32_t BestSeq = 0;
+		for (uint32_t i = 0; i < sFS.SegCount; ++i) {
+			uint32_t Seq = sFS.psIdx[i].Seq;
+			if (Seq <= PrevSeq)
+				continue;							// unused (0) or already visited
+			if (Seg == sFS.SegCount || Seq < BestSeq) {
+				Seg = i;
+				BestSeq = Seq;
+			}
+		}
+		if (Seg == sFS.SegCount)
+			break;									// all live segments visited
+		PrevSeq = BestSeq;
+		if (sFS.psIdx[Seg].TsFirst == logFLASH_TS_OPEN ||
+			sFS.psIdx[Seg].TsFirst > TsTo ||
+			(sFS.psIdx[Seg].TsLast != logFLASH_TS_OPEN && sFS.psIdx[Seg].TsLast < TsFrom))
+			continue;								// cannot contain records in range
+		if (Seg == sFS.CurSeg)
+			vLogFlashFlush(NULL);					// make pending appends visible
+		uint32_t Ofs = sizeof(log_flash_hdr_t);
+		while (Ofs + sizeof(log_flash_rec_t) <= logFLASH_SEG_SIZE) {
+			const log_flash_rec_t * psRec = (const log_flash_rec_t *) &sFS.pcMap[xLogFlashSegBase(Seg) + Ofs];
+			if (psRec->Len == logFLASH_LEN_FREE)
+				break;								// append point reached
+			uint16_t Inv = ~psRec->Len;
+			if (Inv != psRec->Inv)
+				break;								// torn/corrupt record, stop this segment
+			if (psRec->TStamp >= TsFrom && psRec->TStamp <= TsTo) {
+				++Count;
+				if (Cb(Ctx, psRec->TStamp, (const char *) (psRec + 1), psRec->Len))
+					return Count;					// callback asked to stop
+			}
+			Ofs += sizeof(log_flash_rec_t) + ((psRec->Len + 3) & ~3);
+		}
+	}
+	return Count;
+	#endif	// !CONFIG_LOG_SINK_FLASH_COMPRESS
+}
+
+#endif	// CONFIG_LOG_SINK_FLASH
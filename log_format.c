@@ -0,0 +1,225 @@
+/*
+ * log_format.c - specialized formatting kernel for the common log specifier subset
+ * Copyright (c) 2024 Andre M. Maree / KSS Technologies (Pty) Ltd.
+ */
+
+#include "sdkconfig.h"
+
+#if CONFIG_LOG_FAST_FORMAT
+
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_log_private.h"
+
+// ########################################### Macros ##############################################
+
+#define	logFMT_FAST_CACHE_SIZE		32				// fast/fallback memo entries, power of 2
+
+// #################################### local/static variables #####################################
+
+// every two-digit value rendered as a pair, one table load replaces a divide + two modulos
+static const char sPairs[] =
+	"0001020304050607080910111213141516171819"
+	"2021222324252627282930313233343536373839"
+	"4041424344454647484950515253545556575859"
+	"6061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+static const char sHexL[] = "0123456789abcdef";
+static const char sHexU[] = "0123456789ABCDEF";
+
+typedef struct fmt_fast_t {
+	_Atomic uint32_t Seq;							// seqlock, odd while a writer is filling
+	const char * Fmt;								// call site format literal (cache key)
+	uint8_t Fast;									// every conversion in the kernel subset
+} fmt_fast_t;
+// Format strings are static literals so the same pointer recurs for every message
+// from a call site; the subset scan runs once per literal and the verdict is
+// memoized in a direct-mapped cache keyed by pointer identity (same discipline as
+// the fixup cache in log.c). Each entry is a per-entry seqlock (the s_ts64
+// pattern): two literals colliding on a slot from different cores could
+// otherwise publish one key with the other's verdict, and a wrong Fast=1 means
+// misinterpreted varargs. CAS losers just use their locally computed verdict.
+static fmt_fast_t sFastCache[logFMT_FAST_CACHE_SIZE];
+
+// ##################################### private functions #########################################
+
+/**
+ * @brief	One-off scan: does every conversion fall inside the kernel subset?
+ *			Subset: %[0][width]{d,i,u,x,X}, %s, %c, %p, %%. Anything else (float,
+ *			precision, length modifiers, '-' justify) routes to vsnprintf.
+ */
+static int xLogFmtScan(const char * pcFmt) {
+	while ((pcFmt = strchr(pcFmt, '%')) != NULL) {
+		++pcFmt;
+		while (*pcFmt >= '0' && *pcFmt <= '9')
+			++pcFmt;									// flags/width, '0' pad implied
+		switch (*pcFmt) {
+		case 'd': case 'i': case 'u': case 'x': case 'X':
+		case 's': case 'c': case 'p': case '%':
+			++pcFmt;
+			break;
+		default:
+			return 0;									// rare specifier, full printf needed
+		}
+	}
+	return 1;
+}
+
+/**
+ * @brief	Render u32 decimal into the TAIL of a 10 char scratch buffer
+ * @return	pointer to the first digit (digits end at pcEnd)
+ */
+static char * pcLogU32Dec(char * pcEnd, uint32_t Val) {
+	while (Val >= 100) {
+		uint32_t Rem = Val % 100;
+		Val /= 100;
+		*--pcEnd = sPairs[Rem * 2 + 1];
+		*--pcEnd = sPairs[Rem * 2];
+	}
+	if (Val >= 10) {
+		*--pcEnd = sPairs[Val * 2 + 1];
+		*--pcEnd = sPairs[Val * 2];
+	} else {
+		*--pcEnd = '0' + Val;
+	}
+	return pcEnd;
+}
+
+// ##################################### global functions ##########################################
+
+/**
+ * @brief	vsnprintf stand-in for the log record paths, specialized for the
+ *			integer/string subset that makes up nearly all log traffic: LUT based
+ *			itoa, %s by memcpy, no float machinery touched. Formats outside the
+ *			subset are detected once per format literal and that call site uses
+ *			vsnprintf forever after.
+ * @return	as vsnprintf: chars that WOULD have been written excl the NUL, <0 never
+ */
+int xLogFastFormat(char * pcBuf, size_t Size, const char * format, va_list args) {
+	fmt_fast_t * psM = &sFastCache[((uintptr_t) format >> 2) & (logFMT_FAST_CACHE_SIZE - 1)];
+	uint32_t Seq = atomic_load(&psM->Seq);
+	uint8_t Fast;
+	if (((Seq & 1) == 0) && psM->Fmt == format && atomic_load(&psM->Seq) == Seq) {
+		Fast = psM->Fast;							// consistent snapshot, torn read check
+	} else {
+		Fast = xLogFmtScan(format);
+		if (((Seq & 1) == 0) && atomic_compare_exchange_strong(&psM->Seq, &Seq, Seq + 1)) {
+			psM->Fmt = format;
+			psM->Fast = Fast;
+			atomic_store(&psM->Seq, Seq + 2);
+		}
+	}
+	if (!Fast)
+		return vsnprintf(pcBuf, Size, format, args);
+
+	size_t Len = 0;									// virtual length, keeps counting past Size
+	size_t Room = Size ? Size - 1 : 0;				// writable payload bytes
+	// widest renderings: "0x" plus 2 hex digits per pointer byte (18 when
+	// uintptr_t is 64 bits, host/test builds), -2^31 decimal (11 incl sign)
+	char Tmp[(2 + 2 * sizeof(uintptr_t)) > 12 ? 2 + 2 * sizeof(uintptr_t) : 12];
+	while (*format) {
+		if (*format != '%') {						// literal run, bulk copy up to next '%'
+			const char * pcPct = strchr(format, '%');
+			size_t Run = pcPct ? (size_t) (pcPct - format) : strlen(format);
+			if (Len < Room) {
+				size_t Cnt = (Run > Room - Len) ? Room - Len : Run;
+				memcpy(pcBuf + Len, format, Cnt);
+			}
+			Len += Run;
+			format += Run;
+			continue;
+		}
+		++format;									// skip '%'
+		char Pad = ' ';
+		size_t Width = 0;
+		if (*format == '0') {
+			Pad = '0';
+			++format;
+		}
+		while (*format >= '0' && *format <= '9')
+			Width = Width * 10 + (*format++ - '0');
+		const char * pcSrc = Tmp;
+		size_t Cnt = 0;
+		char cConv = *format++;
+		switch (cConv) {
+		case 'd': case 'i': {
+			int iVal = va_arg(args, int);
+			uint32_t uVal = (iVal < 0) ? 0U - (uint32_t) iVal : (uint32_t) iVal;
+			char * pcDig = pcLogU32Dec(&Tmp[sizeof(Tmp)], uVal);
+			if (iVal < 0)
+				*--pcDig = '-';
+			pcSrc = pcDig;
+			Cnt = &Tmp[sizeof(Tmp)] - pcDig;
+			break;
+		}
+		case 'u':
+			pcSrc = pcLogU32Dec(&Tmp[sizeof(Tmp)], va_arg(args, uint32_t));
+			Cnt = &Tmp[sizeof(Tmp)] - pcSrc;
+			break;
+		case 'x': case 'X': case 'p': {
+			const char * pcHex = (cConv == 'X') ? sHexU : sHexL;
+			uintptr_t uVal = (cConv == 'p') ? (uintptr_t) va_arg(args, void *)
+											: va_arg(args, uint32_t);
+			char * pcDig = &Tmp[sizeof(Tmp)];
+			do {
+				*--pcDig = pcHex[uVal & 0xF];
+				uVal >>= 4;
+			} while (uVal);
+			if (cConv == 'p') {
+				*--pcDig = 'x';
+				*--pcDig = '0';
+			}
+			pcSrc = pcDig;
+			Cnt = &Tmp[sizeof(Tmp)] - pcDig;
+			break;
+		}
+		case 's':
+			pcSrc = va_arg(args, const char *);
+			if (pcSrc == NULL)
+				pcSrc = "(null)";
+			Cnt = strlen(pcSrc);
+			break;
+		case 'c':
+			Tmp[0] = (char) va_arg(args, int);
+			Cnt = 1;
+			break;
+		case '%':
+			Tmp[0] = '%';
+			Cnt = 1;
+			break;
+		default:									// scan admitted it, cannot happen
+			Tmp[0] = '?';
+			Cnt = 1;
+			break;
+		}
+		if (Pad == '0' && Cnt && pcSrc[0] == '-') {	// zero pad goes after the sign
+			if (Len < Room)
+				pcBuf[Len] = '-';
+			++Len;
+			++pcSrc;
+			--Cnt;
+			if (Width)
+				--Width;
+		}
+		for (size_t Fill = Cnt; Fill < Width; ++Fill) {	// left pad to width
+			if (Len < Room)
+				pcBuf[Len] = Pad;
+			++Len;
+		}
+		if (Len < Room) {
+			size_t Out = (Cnt > Room - Len) ? Room - Len : Cnt;
+			memcpy(pcBuf + Len, pcSrc, Out);
+		}
+		Len += Cnt;
+	}
+	if (Size)
+		pcBuf[(Len < Room) ? Len : Room] = 0;
+	return (int) Len;
+}
+
+#endif	// CONFIG_LOG_FAST_FORMAT
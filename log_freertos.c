@@ -4,7 +4,10 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <stdatomic.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <sys/time.h>
 #include "freertos/FreeRTOS.h"
@@ -26,8 +29,86 @@
 
 static SemaphoreHandle_t s_log_mutex = NULL;
 
+// Per-task log context block (log_task_ctx_t, see esp_log_private.h), allocated on
+// first use and stored via the FreeRTOS thread-local-storage pointer at
+// CONFIG_LOG_TLS_INDEX. Never freed: tasks which log are long-lived in practice,
+// and FreeRTOS has no TLS destructor callback.
+
+#if CONFIG_LOG_LINE_ASSEMBLY
+// every allocated context block, so the drain task can sweep stale fragments;
+// blocks are never freed so lock-free traversal of the list is safe
+static log_task_ctx_t *s_ctx_list = NULL;
+static portMUX_TYPE s_ctx_list_mux = portMUX_INITIALIZER_UNLOCKED;
+
+log_task_ctx_t *esp_log_task_ctx_list(void)
+{
+    return s_ctx_list;
+}
+#endif
+
+log_task_ctx_t *esp_log_task_ctx_get(void)
+{
+    // early boot / ISR / alloc failure; shared between callers, so marked unfit
+    // for anything cached per task (line assembly, prefix)
+    static log_task_ctx_t s_ctx_fallback = { .Shared = 1 };
+
+    if (xTaskGetSchedulerState() != taskSCHEDULER_RUNNING || xPortInIsrContext()) {
+        return &s_ctx_fallback;
+    }
+    log_task_ctx_t *ctx = pvTaskGetThreadLocalStoragePointer(NULL, CONFIG_LOG_TLS_INDEX);
+    if (ctx == NULL) {
+        ctx = calloc(1, sizeof(log_task_ctx_t));
+        if (ctx == NULL) {
+            return &s_ctx_fallback;
+        }
+#if CONFIG_LOG_LINE_ASSEMBLY
+        portENTER_CRITICAL(&s_ctx_list_mux);
+        ctx->Next = s_ctx_list;
+        s_ctx_list = ctx;
+        portEXIT_CRITICAL(&s_ctx_list_mux);
+#endif
+        vTaskSetThreadLocalStoragePointer(NULL, CONFIG_LOG_TLS_INDEX, ctx);
+    }
+    return ctx;
+}
+
+// Pre-rendered "taskname[core]" prefix, built on the first log call from each
+// task: downstream formatters (xvSyslog) get a TLS load plus memcpy instead of
+// a pcTaskGetName() lookup-and-format cycle per message. For tasks not pinned
+// to a core the suffix shows the core the task first logged on.
+const char *esp_log_task_prefix(uint8_t *len)
+{
+    log_task_ctx_t *ctx = esp_log_task_ctx_get();
+    if (unlikely(ctx->Shared)) {
+        if (len) {
+            *len = 5;
+        }
+        return "early";     // ISR / pre-scheduler / alloc failure, nothing to cache
+    }
+    if (unlikely(ctx->PrefixLen == 0)) {
+        int n = snprintf(ctx->Prefix, sizeof(ctx->Prefix), "%s[%d]",
+                         pcTaskGetName(NULL), xPortGetCoreID());
+        ctx->PrefixLen = (n < 0) ? 0 : (n >= (int) sizeof(ctx->Prefix)) ? sizeof(ctx->Prefix) - 1 : n;
+    }
+    if (len) {
+        *len = ctx->PrefixLen;
+    }
+    return ctx->Prefix;
+}
+
+// Seqlock-style cache of the "HH:MM:SS" prefix: localtime_r + formatting run only
+// when the second rolls over, every other call is a memcpy plus 3 digit stores.
+static struct {
+    _Atomic uint32_t seq;   // odd while a writer is updating
+    time_t second;
+    char hms[9];
+} s_time_cache;
+
 void esp_log_impl_lock(void)
 {
+    if (unlikely(esp_log_in_panic)) {
+        return;     // panic path is lock-free by design; the taker may be dead
+    }
     if (unlikely(!s_log_mutex)) {
         s_log_mutex = xSemaphoreCreateMutex();
     }
@@ -39,17 +120,29 @@ void esp_log_impl_lock(void)
 
 bool esp_log_impl_lock_timeout(void)
 {
+    if (unlikely(esp_log_in_panic)) {
+        return true;
+    }
     if (unlikely(!s_log_mutex)) {
         s_log_mutex = xSemaphoreCreateMutex();
     }
     if (unlikely(xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED)) {
         return true;
     }
-    return xSemaphoreTake(s_log_mutex, MAX_MUTEX_WAIT_TICKS) == pdTRUE;
+    if (xSemaphoreTake(s_log_mutex, MAX_MUTEX_WAIT_TICKS) != pdTRUE) {
+#if CONFIG_LOG_STATS
+        vLogStatsLockTimeout();
+#endif
+        return false;
+    }
+    return true;
 }
 
 void esp_log_impl_unlock(void)
 {
+    if (unlikely(esp_log_in_panic)) {
+        return;
+    }
     if (unlikely(xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED)) {
         return;
     }
@@ -59,7 +152,6 @@ void esp_log_impl_unlock(void)
 char *esp_log_system_timestamp(void)
 {
     static char buffer[18] = {0};
-    static _lock_t bufferLock = 0;
 
     if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) {
         uint32_t timestamp = esp_log_early_timestamp();
@@ -78,21 +170,36 @@ char *esp_log_system_timestamp(void)
         return buffer;
     } else {
         struct timeval tv;
-        struct tm timeinfo;
+        char *out = esp_log_task_ctx_get()->ts_buf;
 
         gettimeofday(&tv, NULL);
-        localtime_r(&tv.tv_sec, &timeinfo);
-
-        _lock_acquire(&bufferLock);
-        snprintf(buffer, sizeof(buffer),
-                 "%02d:%02d:%02d.%03ld",
-                 timeinfo.tm_hour,
-                 timeinfo.tm_min,
-                 timeinfo.tm_sec,
-                 tv.tv_usec / 1000);
-        _lock_release(&bufferLock);
-
-        return buffer;
+        uint32_t seq = atomic_load(&s_time_cache.seq);
+        bool hit = false;
+        if (((seq & 1) == 0) && (s_time_cache.second == tv.tv_sec)) {
+            memcpy(out, s_time_cache.hms, 8);
+            hit = (atomic_load(&s_time_cache.seq) == seq);  // torn read check
+        }
+        if (!hit) {
+            struct tm timeinfo;
+            localtime_r(&tv.tv_sec, &timeinfo);
+            snprintf(out, 9, "%02d:%02d:%02d",
+                     timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
+            // publish for the next second's worth of callers; losing the CAS just
+            // means another task is already refreshing the cache for this second
+            if (((seq & 1) == 0) &&
+                    atomic_compare_exchange_strong(&s_time_cache.seq, &seq, seq + 1)) {
+                s_time_cache.second = tv.tv_sec;
+                memcpy(s_time_cache.hms, out, 8);
+                atomic_store(&s_time_cache.seq, seq + 2);
+            }
+        }
+        uint32_t msec = tv.tv_usec / 1000;      // patch ".sss" per call
+        out[8] = '.';
+        out[9] = '0' + msec / 100;
+        out[10] = '0' + (msec / 10) % 10;
+        out[11] = '0' + msec % 10;
+        out[12] = 0;
+        return out;
     }
 }
 
@@ -109,14 +216,82 @@ uint32_t esp_log_timestamp(void)
     return base + tick_count * (1000 / configTICK_RATE_HZ);
 }
 
+// 64-bit tick extension, seqlock guarded: readers never take a lock, the caller
+// which first observes a 32-bit tick wrap (or a stale low word) publishes the
+// new high word under a CAS-claimed odd sequence count. The write side runs
+// inside a critical section: readers spin while seq is odd, so a writer
+// preempted (or interrupted - this is ISR callable) mid-update would leave
+// every same-core reader spinning against a writer that can never run.
+static struct {
+    _Atomic uint32_t seq;   // odd while a writer is updating
+    uint32_t last_lo;
+    uint32_t high;
+} s_ts64;
+static portMUX_TYPE s_ts64_mux = portMUX_INITIALIZER_UNLOCKED;
+
+uint64_t esp_log_timestamp64(void)
+{
+    uint32_t seq, hi, last;
+    TickType_t lo;
+    for (;;) {
+        // the tick MUST be read inside the verified snapshot window: a tick
+        // captured before it can straddle another caller's last_lo refresh,
+        // making a merely stale lo compare below last and fake a wrap - a
+        // published high+1 with last_lo regressed is a permanent 2^32-tick jump
+        do {
+            seq = atomic_load(&s_ts64.seq);
+            hi = s_ts64.high;
+            last = s_ts64.last_lo;
+            lo = xPortInIsrContext() ? xTaskGetTickCountFromISR() : xTaskGetTickCount();
+        } while ((seq & 1) || (atomic_load(&s_ts64.seq) != seq));
+        if (lo >= last)
+            break;
+        // genuinely wrapped since the snapshot was published; winning the CAS
+        // proves the snapshot is still current, so publishing is safe. Losing
+        // it means another caller updated first: retry from a fresh snapshot
+        // instead of guessing locally which update won.
+        int won;
+        portENTER_CRITICAL_SAFE(&s_ts64_mux);
+        won = atomic_compare_exchange_strong(&s_ts64.seq, &seq, seq + 1);
+        if (won) {
+            s_ts64.high = ++hi;
+            s_ts64.last_lo = lo;
+            atomic_store(&s_ts64.seq, seq + 2);
+        }
+        portEXIT_CRITICAL_SAFE(&s_ts64_mux);
+        if (won) {
+            return (((uint64_t)hi << 32) | lo) * (portTICK_PERIOD_MS * 1000ULL);
+        }
+    }
+    if ((lo - last) > 0x40000000UL) {
+        portENTER_CRITICAL_SAFE(&s_ts64_mux);
+        if (atomic_compare_exchange_strong(&s_ts64.seq, &seq, seq + 1)) {
+            s_ts64.last_lo = lo;    // refresh the snapshot well before wrap
+            atomic_store(&s_ts64.seq, seq + 2);
+        }
+        portEXIT_CRITICAL_SAFE(&s_ts64_mux);
+    }
+    return (((uint64_t)hi << 32) | lo) * (portTICK_PERIOD_MS * 1000ULL);
+}
+
 /* FIXME: define an API for getting the timestamp in soc/hal IDF-2351 */
+// Runtime divides replaced by a fixed-point reciprocal multiply; the reciprocal is
+// recomputed only when the cycle clock rate changes (first call, DFS transitions).
+static uint32_t s_early_div;
+static uint32_t s_early_recip;
+
 uint32_t esp_log_early_timestamp(void)
 {
 #if CONFIG_IDF_TARGET_ESP32
     /* ESP32 ROM stores separate clock rate values for each CPU, but we want the PRO CPU value always */
     extern uint32_t g_ticks_per_us_pro;
-    return esp_cpu_get_cycle_count() / (g_ticks_per_us_pro * 1000);
+    uint32_t div = g_ticks_per_us_pro * 1000;
 #else
-    return esp_cpu_get_cycle_count() / (esp_rom_get_cpu_ticks_per_us() * 1000);
+    uint32_t div = esp_rom_get_cpu_ticks_per_us() * 1000;
 #endif
+    if (unlikely(div != s_early_div)) {
+        s_early_recip = (uint32_t)((1ULL << 32) / div);
+        s_early_div = div;
+    }
+    return (uint32_t)(((uint64_t)esp_cpu_get_cycle_count() * s_early_recip) >> 32);
 }
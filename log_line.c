@@ -0,0 +1,118 @@
+/*
+ * log_line.c - per-task assembly of partial writes into single log records
+ * Copyright (c) 2024 Andre M. Maree / KSS Technologies (Pty) Ltd.
+ *
+ * Some libraries emit one logical line as several log calls (the wifi blob's
+ * 3-printf pattern being the canonical offender). With assembly enabled a call
+ * whose formatted output lacks a trailing newline is treated as a fragment and
+ * accumulated in the calling task's TLS context block; the whole line goes out
+ * as ONE record when the terminating newline arrives, when the buffer fills,
+ * or when the drain task finds the fragment idle past the timeout. One record
+ * per line means one lock round-trip, one sink call, and no interleaved
+ * half-lines from the two cores.
+ *
+ * Opt-in (default n): records in this component are NOT newline terminated,
+ * framing being the sink's job, so with assembly enabled every plain ESP_LOGx()
+ * incurs the timeout latency. Only enable on trees whose output is newline
+ * framed throughout.
+ */
+
+#include "sdkconfig.h"
+
+#if CONFIG_LOG_LINE_ASSEMBLY
+
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_log_private.h"
+
+// ########################################### Macros ##############################################
+
+#define	logLINE_BUF_SIZE			CONFIG_LOG_LINE_ASSEMBLY_SIZE
+#define	logLINE_FLUSH_TICKS			pdMS_TO_TICKS(CONFIG_LOG_LINE_ASSEMBLY_TIMEOUT)
+
+// #################################### local/static variables #####################################
+
+// guards Line/Len/Tag/Prio of every context block against the timeout sweep;
+// held only around memory moves, never across output
+static portMUX_TYPE sLineMux = portMUX_INITIALIZER_UNLOCKED;
+
+// ##################################### private functions #########################################
+
+/**
+ * @brief	Detach the pending fragment under the spinlock, emit it outside
+ */
+static void vLogLineFlush(log_task_ctx_t * psCtx) {
+	char Line[logLINE_BUF_SIZE];
+	portENTER_CRITICAL(&sLineMux);
+	uint16_t Len = psCtx->Len;
+	int Prio = psCtx->Prio;
+	const char * Tag = psCtx->Tag;
+	if (Len) {
+		memcpy(Line, psCtx->Line, Len);				// Len < logLINE_BUF_SIZE by construction
+		psCtx->Len = 0;
+	}
+	portEXIT_CRITICAL(&sLineMux);
+	if (Len) {
+		Line[Len] = 0;
+		vLogTextEmit(Prio, Tag, Line);
+	}
+}
+
+// #################################### public/global functions ####################################
+
+/**
+ * @brief	Accumulate a formatted message in the calling task's context block
+ * @return	1 if consumed (buffered and/or emitted), 0 if the caller must fall
+ *			back to the normal output path (ISR, pre-scheduler, no TLS block)
+ */
+int xLogLineAssemble(int Priority, const char * MsgID, const char * format, va_list args) {
+	log_task_ctx_t * psCtx = esp_log_task_ctx_get();
+	if (psCtx->Shared)
+		return 0;									// shared fallback block, no assembly
+	char Frag[logLINE_BUF_SIZE];
+	int Len = xLogFastFormat(Frag, sizeof(Frag), format, args);
+	if (Len < 0)
+		return 1;
+	if (Len >= (int) sizeof(Frag))
+		Len = sizeof(Frag) - 1;
+	int Complete = (Len > 0) && (Frag[Len - 1] == '\n');
+	while (Len && (Frag[Len - 1] == '\n' || Frag[Len - 1] == '\r'))
+		--Len;										// strip framing, the sink re-adds its own
+	if (psCtx->Len && (psCtx->Prio != Priority || psCtx->Tag != MsgID))
+		vLogLineFlush(psCtx);						// unrelated fragment pending, emit as-is
+	portENTER_CRITICAL(&sLineMux);
+	if ((psCtx->Len + Len) > (logLINE_BUF_SIZE - 1)) {
+		portEXIT_CRITICAL(&sLineMux);				// line longer than the buffer, emit the
+		vLogLineFlush(psCtx);						// part on hand; Frag alone always fits
+		portENTER_CRITICAL(&sLineMux);
+	}
+	memcpy(&psCtx->Line[psCtx->Len], Frag, Len);
+	psCtx->Len += Len;
+	psCtx->Prio = Priority;
+	psCtx->Tag = MsgID;
+	psCtx->LastTick = xTaskGetTickCount();
+	portEXIT_CRITICAL(&sLineMux);
+	if (Complete)
+		vLogLineFlush(psCtx);
+	return 1;
+}
+
+/**
+ * @brief	Timeout flush of idle fragments, called from the drain task.
+ *			A task that emitted a fragment and then went quiet (or died before
+ *			the newline) still gets its partial line out within the timeout.
+ */
+void vLogLineSweep(void) {
+	uint32_t Now = xTaskGetTickCount();
+	for (log_task_ctx_t * psCtx = esp_log_task_ctx_list(); psCtx; psCtx = psCtx->Next) {
+		if (psCtx->Len && (Now - psCtx->LastTick) >= logLINE_FLUSH_TICKS)
+			vLogLineFlush(psCtx);
+	}
+}
+
+#endif	// CONFIG_LOG_LINE_ASSEMBLY
@@ -29,10 +29,19 @@ void esp_log_impl_unlock(void)
 }
 
 /* FIXME: define an API for getting the timestamp in soc/hal IDF-2351 */
+// divide replaced by a fixed-point reciprocal multiply, recomputed only when the
+// CPU frequency changes (first call, DFS transitions)
 uint32_t esp_log_early_timestamp(void)
 {
     extern uint32_t ets_get_cpu_frequency(void);
-    return cpu_hal_get_cycle_count() / (ets_get_cpu_frequency() * 1000);
+    static uint32_t s_div;
+    static uint32_t s_recip;
+    uint32_t div = ets_get_cpu_frequency() * 1000;
+    if (div != s_div) {
+        s_recip = (uint32_t)((1ULL << 32) / div);
+        s_div = div;
+    }
+    return (uint32_t)(((uint64_t)cpu_hal_get_cycle_count() * s_recip) >> 32);
 }
 
 uint32_t esp_log_timestamp(void) __attribute__((alias("esp_log_early_timestamp")));
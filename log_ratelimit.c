@@ -0,0 +1,110 @@
+/*
+ * log_ratelimit.c - per-callsite token bucket rate limiting + repeat aggregation
+ * Copyright (c) 2024 Andre M. Maree / KSS Technologies (Pty) Ltd.
+ *
+ * A flooding call site (e.g. a driver re-logging the same bus error thousands
+ * of times per second) is identified by its format string pointer, which is
+ * unique per call site. Each site gets a token bucket: once the burst budget
+ * is spent further messages are suppressed and counted, and a single
+ * "last message repeated N times" summary is emitted when tokens return or
+ * when the periodic sweep (drain task) notices an idle suppressed site.
+ */
+
+#include "sdkconfig.h"
+
+#if CONFIG_LOG_RATELIMIT
+
+#include <stdatomic.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_log_private.h"
+
+// ########################################### Macros ##############################################
+
+#define	logRL_SLOTS					32				// direct mapped by format pointer, power of 2
+#define	logRL_BURST					CONFIG_LOG_RATELIMIT_BURST
+#define	logRL_RATE					CONFIG_LOG_RATELIMIT_RATE
+
+// ######################################## Structures #############################################
+
+typedef struct log_rl_slot_t {
+	const char * Fmt;								// call site key, NULL = unused
+	const char * Tag;								// for the summary line
+	uint32_t LastMs;								// last refill timestamp
+	uint32_t Suppressed;							// messages swallowed since last summary
+	_Atomic uint16_t Tokens;						// admission counter, must never underflow
+	uint8_t Prio;									// priority of the suppressed messages
+} log_rl_slot_t;
+
+// #################################### local/static variables #####################################
+
+static log_rl_slot_t sSlots[logRL_SLOTS];
+
+// ##################################### private functions #########################################
+
+static void vLogRateLimitSummary(log_rl_slot_t * psS) {
+	if (psS->Suppressed == 0)
+		return;
+	vSyslog(psS->Prio, psS->Tag, "last message repeated %u times (rate limited)", psS->Suppressed);
+	psS->Suppressed = 0;
+}
+
+static void vLogRateLimitRefill(log_rl_slot_t * psS, uint32_t NowMs) {
+	uint32_t Earned = ((NowMs - psS->LastMs) * logRL_RATE) / 1000;
+	if (Earned == 0)
+		return;
+	psS->LastMs = NowMs;
+	uint16_t Tokens = atomic_load(&psS->Tokens);
+	Tokens = (Tokens + Earned > logRL_BURST) ? logRL_BURST : Tokens + Earned;
+	atomic_store(&psS->Tokens, Tokens);
+	if (Tokens)
+		vLogRateLimitSummary(psS);					// flowing again, report what was lost
+}
+
+// #################################### public/global functions ####################################
+
+/**
+ * @brief	Admission check for one message, called from esp_log_writev()
+ * @return	1 = pass the message through, 0 = suppress (already counted)
+ */
+int xLogRateLimitCheck(int Priority, const char * tag, const char * format) {
+	log_rl_slot_t * psS = &sSlots[((uintptr_t) format >> 2) & (logRL_SLOTS - 1)];
+	uint32_t NowMs = esp_log_timestamp();
+	if (psS->Fmt != format) {						// new or evicted call site
+		vLogRateLimitSummary(psS);					// flush any pending count for the old owner
+		psS->Fmt = format;
+		psS->Tag = tag;
+		atomic_store(&psS->Tokens, logRL_BURST);
+		psS->LastMs = NowMs;
+	}
+	psS->Prio = Priority;
+	vLogRateLimitRefill(psS, NowMs);
+	/* The slot's other fields tolerate racing writers (worst case a duplicated
+	 * summary or an off-by-a-few count), but the admission counter must not:
+	 * two cores decrementing from 1 would underflow to 65535 and disable
+	 * suppression for the next 64K messages. CAS with a zero floor. */
+	uint16_t Tokens = atomic_load(&psS->Tokens);
+	do {
+		if (Tokens == 0) {
+			++psS->Suppressed;
+			return 0;
+		}
+	} while (!atomic_compare_exchange_weak(&psS->Tokens, &Tokens, Tokens - 1));
+	return 1;
+}
+
+/**
+ * @brief	Periodic sweep from the drain task: emit summaries for sites that went
+ *			quiet while suppressed, so counts are not held back indefinitely.
+ */
+void vLogRateLimitSweep(void) {
+	uint32_t NowMs = esp_log_timestamp();
+	for (int i = 0; i < logRL_SLOTS; ++i) {
+		log_rl_slot_t * psS = &sSlots[i];
+		if (psS->Fmt && psS->Suppressed)
+			vLogRateLimitRefill(psS, NowMs);
+	}
+}
+
+#endif	// CONFIG_LOG_RATELIMIT
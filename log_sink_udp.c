@@ -0,0 +1,170 @@
+/*
+ * log_sink_udp.c - UDP syslog sink with coalescing and non-blocking sends
+ * Copyright (c) 2024 Andre M. Maree / KSS Technologies (Pty) Ltd.
+ *
+ * Replaces the blocking sendto-per-line vprintf hook: records accepted from
+ * the sink dispatch are copied into a byte ring, a dedicated low priority
+ * task coalesces multiple lines into one datagram (RFC5424-ish framing, one
+ * line per message separated by \n inside the datagram) and sends on a
+ * non-blocking socket. Ring overflow drops the oldest records and counts
+ * them; the logging caller is never blocked by a congested AP.
+ */
+
+#include "sdkconfig.h"
+
+#if CONFIG_LOG_SINK_UDP
+
+#include <fcntl.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "lwip/netdb.h"
+#include "lwip/sockets.h"
+
+#include "esp_log.h"
+#include "esp_log_sink.h"
+#include "esp_log_private.h"
+
+// ########################################### Macros ##############################################
+
+#define	logUDP_RING_SIZE			CONFIG_LOG_SINK_UDP_RING_SIZE
+#define	logUDP_DGRAM_SIZE			CONFIG_LOG_SINK_UDP_DGRAM_SIZE
+#define	logUDP_TASK_STACK			3072
+#define	logUDP_TASK_PRIO			2
+#define	logUDP_IDLE_TICKS			pdMS_TO_TICKS(50)
+
+// #################################### local/static variables #####################################
+
+static struct {
+	uint8_t Ring[logUDP_RING_SIZE];					// length-prefixed (u16) records
+	uint32_t Head;									// byte offsets, wrap by modulo
+	uint32_t Tail;
+	uint32_t Drops;									// records lost to ring overflow
+	portMUX_TYPE Mux;
+	struct sockaddr_in Dest;
+	int Sock;
+	TaskHandle_t Task;
+	int Handle;										// sink registry handle
+} sUdp = { .Mux = portMUX_INITIALIZER_UNLOCKED, .Sock = -1, .Handle = -1 };
+
+// ##################################### private functions #########################################
+
+static uint32_t xLogUdpUsed(void) { return sUdp.Head - sUdp.Tail; }
+
+static void vLogUdpPutBytes(const uint8_t * pU8, uint32_t Len) {
+	for (uint32_t i = 0; i < Len; ++i)
+		sUdp.Ring[(sUdp.Head + i) % logUDP_RING_SIZE] = pU8[i];
+	sUdp.Head += Len;
+}
+
+static void vLogUdpGetBytes(uint8_t * pU8, uint32_t Len) {
+	for (uint32_t i = 0; i < Len; ++i)
+		pU8[i] = sUdp.Ring[(sUdp.Tail + i) % logUDP_RING_SIZE];
+	sUdp.Tail += Len;
+}
+
+static void vLogUdpDropOldest(void) {
+	uint16_t Len;
+	vLogUdpGetBytes((uint8_t *) &Len, sizeof(Len));
+	sUdp.Tail += Len;
+	++sUdp.Drops;
+}
+
+/**
+ * @brief	Sink write callback, runs in the drain task (or logging task on the
+ *			synchronous fallback path). Copies the record and returns; never sends.
+ */
+static void vLogUdpWrite(void * ctx, int prio, const char * tag, const char * text, size_t len) {
+	char line[logUDP_DGRAM_SIZE];
+	int iRV = snprintf(line, sizeof(line), "<%d>%s %.*s", prio, tag, (int) len, text);
+	if (iRV < 0)
+		return;
+	uint16_t Len = (iRV >= (int) sizeof(line)) ? sizeof(line) - 1 : iRV;
+	if (Len > logUDP_RING_SIZE - sizeof(Len) - 1)	// must fit an EMPTY ring or the
+		Len = logUDP_RING_SIZE - sizeof(Len) - 1;	// drop-oldest loop never terminates
+	portENTER_CRITICAL(&sUdp.Mux);
+	while (xLogUdpUsed() + sizeof(Len) + Len > logUDP_RING_SIZE)
+		vLogUdpDropOldest();						// drop oldest, never block the caller
+	vLogUdpPutBytes((uint8_t *) &Len, sizeof(Len));
+	vLogUdpPutBytes((uint8_t *) line, Len);
+	portEXIT_CRITICAL(&sUdp.Mux);
+	if (sUdp.Task)
+		xTaskNotifyGive(sUdp.Task);
+}
+
+static void vLogUdpTask(void * pvPara) {
+	uint8_t dgram[logUDP_DGRAM_SIZE];
+	while (1) {
+		ulTaskNotifyTake(pdTRUE, logUDP_IDLE_TICKS);
+		while (1) {
+			uint32_t Fill = 0;
+			portENTER_CRITICAL(&sUdp.Mux);
+			while (xLogUdpUsed()) {					// coalesce records into one datagram
+				uint16_t Len;
+				uint32_t SavedTail = sUdp.Tail;
+				vLogUdpGetBytes((uint8_t *) &Len, sizeof(Len));
+				if (Fill + Len + 1 > logUDP_DGRAM_SIZE) {
+					sUdp.Tail = SavedTail;			// leave it for the next datagram
+					break;
+				}
+				if (Fill)
+					dgram[Fill++] = '\n';
+				vLogUdpGetBytes(&dgram[Fill], Len);
+				Fill += Len;
+			}
+			portEXIT_CRITICAL(&sUdp.Mux);
+			if (Fill == 0)
+				break;
+			// non-blocking: a full transmit queue (congested AP) just drops the datagram
+			sendto(sUdp.Sock, dgram, Fill, 0, (struct sockaddr *) &sUdp.Dest, sizeof(sUdp.Dest));
+		}
+	}
+}
+
+// #################################### public/global functions ####################################
+
+/**
+ * @brief	Start forwarding log output to a UDP syslog collector
+ * @param	host	collector address, dotted quad or resolvable name
+ * @param	port	collector port, 0 selects the syslog default 514
+ * @param	min_level	only messages at this level or more severe are forwarded
+ * @return	sink handle (>= 0) or -1 on resolve/socket/registration failure
+ */
+int esp_log_sink_udp_start(const char * host, uint16_t port, esp_log_level_t min_level) {
+	if (sUdp.Handle >= 0)
+		return sUdp.Handle;							// already running
+	struct addrinfo hints = { .ai_family = AF_INET, .ai_socktype = SOCK_DGRAM };
+	struct addrinfo * res = NULL;
+	if (getaddrinfo(host, NULL, &hints, &res) != 0 || res == NULL)
+		return -1;
+	sUdp.Dest = *(struct sockaddr_in *) res->ai_addr;
+	sUdp.Dest.sin_port = htons(port ? port : 514);
+	freeaddrinfo(res);
+	sUdp.Sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (sUdp.Sock < 0)
+		return -1;
+	fcntl(sUdp.Sock, F_SETFL, fcntl(sUdp.Sock, F_GETFL, 0) | O_NONBLOCK);
+	if (sUdp.Task == NULL)
+		xTaskCreate(vLogUdpTask, "log_udp", logUDP_TASK_STACK, NULL, logUDP_TASK_PRIO, &sUdp.Task);
+	esp_log_sink_t sSink = {
+		.name = "udp",
+		.min_level = min_level,
+		.write = vLogUdpWrite,
+	};
+	sUdp.Handle = esp_log_sink_register(&sSink);
+	return sUdp.Handle;
+}
+
+void esp_log_sink_udp_stop(void) {
+	if (sUdp.Handle < 0)
+		return;
+	esp_log_sink_unregister(sUdp.Handle);
+	sUdp.Handle = -1;
+	close(sUdp.Sock);
+	sUdp.Sock = -1;
+}
+
+uint32_t esp_log_sink_udp_drops(void) { return sUdp.Drops; }
+
+#endif	// CONFIG_LOG_SINK_UDP
@@ -0,0 +1,140 @@
+/*
+ * log_sinks.c - registry and fan-out of formatted log records to N output sinks
+ * Copyright (c) 2024 Andre M. Maree / KSS Technologies (Pty) Ltd.
+ */
+
+#include "sdkconfig.h"
+
+#if CONFIG_LOG_SINKS
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_log_sink.h"
+#include "esp_log_private.h"
+
+// ########################################### Macros ##############################################
+
+#define	logSINK_MAX					CONFIG_LOG_SINK_MAX
+
+// #################################### local/static variables #####################################
+
+static esp_log_sink_t sSinks[logSINK_MAX];
+static uint8_t sSinkUsed[logSINK_MAX];
+
+#if CONFIG_LOG_STATS
+static uint32_t sFlushMaxUs[logSINK_MAX];			// per-sink flush latency high-water
+#endif
+
+// ##################################### private functions #########################################
+
+/**
+ * @brief	Default console sink, routes through the existing syslog text path.
+ *			Registered implicitly on first dispatch so behaviour without any
+ *			esp_log_sink_register() call is unchanged from before.
+ */
+static void vLogSinkConsole(void * ctx, int prio, const char * tag, const char * text, size_t len) {
+	vSyslog(prio, tag, "%.*s", (int) len, text);	// honour len, text may be an unterminated slice
+}
+
+static void vLogSinkInit(void) {
+	if (sSinkUsed[0])
+		return;
+	sSinks[0] = (esp_log_sink_t) {
+		.name = "console",
+		.min_level = ESP_LOG_VERBOSE,
+		.write = vLogSinkConsole,
+	};
+	sSinkUsed[0] = 1;
+}
+
+// #################################### public/global functions ####################################
+
+int esp_log_sink_register(const esp_log_sink_t * psSink) {
+	if (psSink == NULL || psSink->write == NULL)
+		return -1;
+	vLogSinkInit();
+	esp_log_impl_lock();
+	int handle = -1;
+	for (int i = 0; i < logSINK_MAX; ++i) {
+		if (!sSinkUsed[i]) {
+			sSinks[i] = *psSink;
+			sSinkUsed[i] = 1;
+			handle = i;
+			break;
+		}
+	}
+	esp_log_impl_unlock();
+	return handle;
+}
+
+int esp_log_sink_unregister(int handle) {
+	if (handle < 0 || handle >= logSINK_MAX || !sSinkUsed[handle])
+		return -1;
+	esp_log_impl_lock();
+	sSinkUsed[handle] = 0;
+	memset(&sSinks[handle], 0, sizeof(esp_log_sink_t));
+	esp_log_impl_unlock();
+	return 0;
+}
+
+int esp_log_sink_set_level(int handle, esp_log_level_t level) {
+	if (handle < 0 || handle >= logSINK_MAX || !sSinkUsed[handle])
+		return -1;
+	sSinks[handle].min_level = level;
+	return 0;
+}
+
+/**
+ * @brief	Offer one formatted record, by reference, to every admitting sink.
+ *			Called from the drain task (deferred mode) or the logging task itself
+ *			(synchronous fallback). Priority carries the syslog adjusted level,
+ *			level filtering maps it back to esp_log_level_t space.
+ */
+void vLogSinkDispatch(int prio, const char * tag, const char * text, size_t len) {
+	vLogSinkInit();
+	esp_log_level_t level = (prio > 2) ? (esp_log_level_t) (prio - 2) : ESP_LOG_ERROR;
+	for (int i = 0; i < logSINK_MAX; ++i) {
+		if (sSinkUsed[i] && level <= sSinks[i].min_level)
+			sSinks[i].write(sSinks[i].ctx, prio, tag, text, len);
+	}
+}
+
+/**
+ * @brief	Run every sink's flush hook; called periodically from the drain task.
+ *			With stats enabled each flush is timed and the per-sink high-water
+ *			mark kept - a sink going slow in the field shows up in the stats
+ *			report long before it backpressures the drain task noticeably.
+ */
+void vLogSinkFlushAll(void) {
+	for (int i = 0; i < logSINK_MAX; ++i) {
+		if (sSinkUsed[i] && sSinks[i].flush) {
+			#if CONFIG_LOG_STATS
+			uint32_t t0 = esp_cpu_get_cycle_count();
+			sSinks[i].flush(sSinks[i].ctx);
+			#if CONFIG_IDF_TARGET_ESP32
+			extern uint32_t g_ticks_per_us_pro;
+			uint32_t Us = (esp_cpu_get_cycle_count() - t0) / g_ticks_per_us_pro;
+			#else
+			uint32_t Us = (esp_cpu_get_cycle_count() - t0) / esp_rom_get_cpu_ticks_per_us();
+			#endif
+			if (Us > sFlushMaxUs[i])
+				sFlushMaxUs[i] = Us;
+			#else
+			sSinks[i].flush(sSinks[i].ctx);
+			#endif
+		}
+	}
+}
+
+uint32_t ulLogSinkFlushMaxUs(int handle) {
+	#if CONFIG_LOG_STATS
+	if (handle >= 0 && handle < logSINK_MAX)
+		return sFlushMaxUs[handle];
+	#else
+	(void) handle;
+	#endif
+	return 0;
+}
+
+#endif	// CONFIG_LOG_SINKS
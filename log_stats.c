@@ -0,0 +1,95 @@
+/*
+ * log_stats.c - always-on health counters for the logging pipeline
+ * Copyright (c) 2024 Andre M. Maree / KSS Technologies (Pty) Ltd.
+ *
+ * Once output is asynchronous, pipeline health must be visible without a
+ * debugger: messages per level, lock timeout expiries, ring-full drops and
+ * per-sink flush latency high-water marks. Counters live in per-core,
+ * cache-line padded slots so counting never bounces a line between cores; the
+ * increments are plain (not atomic), so a same-core preemption can very rarely
+ * lose one count - acceptable for health statistics, free on the hot path.
+ * esp_log_stats_get() aggregates the slots plus the drop/latency counters the
+ * other stages already keep; the drain task emits a one-line self-report every
+ * CONFIG_LOG_STATS_PERIOD seconds so field units document their own health.
+ */
+
+#include "sdkconfig.h"
+
+#if CONFIG_LOG_STATS
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+
+#include "esp_log.h"
+#include "esp_log_private.h"
+
+// ######################################## Structures #############################################
+
+typedef struct log_stats_core_t {
+	uint32_t Levels[ESP_LOG_VERBOSE + 1];			// accepted messages, indexed by level
+	uint32_t LockTimeouts;
+	uint8_t Pad[64 - (((ESP_LOG_VERBOSE + 2) * 4) & 63)];
+} log_stats_core_t;
+
+// #################################### local/static variables #####################################
+
+static log_stats_core_t sCores[portNUM_PROCESSORS] __attribute__((aligned(64)));
+static uint32_t sLastReport;						// esp_log_timestamp() of the last self-report
+
+// #################################### public/global functions ####################################
+
+// hot path: one core-local increment, no atomics, no shared lines
+void vLogStatsLevel(int Level) {
+	if (Level >= 0 && Level <= ESP_LOG_VERBOSE)
+		++sCores[xPortGetCoreID()].Levels[Level];
+}
+
+void vLogStatsLockTimeout(void) {
+	++sCores[xPortGetCoreID()].LockTimeouts;
+}
+
+void esp_log_stats_get(esp_log_stats_t * psStats) {
+	memset(psStats, 0, sizeof(*psStats));
+	for (int c = 0; c < portNUM_PROCESSORS; ++c) {
+		for (int i = 0; i <= ESP_LOG_VERBOSE; ++i)
+			psStats->MsgCount[i] += sCores[c].Levels[i];
+		psStats->LockTimeouts += sCores[c].LockTimeouts;
+	}
+	#if CONFIG_LOG_DEFERRED
+	psStats->RingDrops = ulLogDeferDropCount();
+	#endif
+	#if CONFIG_LOG_SINKS
+	for (int i = 0; i < CONFIG_LOG_SINK_MAX; ++i)
+		psStats->SinkFlushMaxUs[i] = ulLogSinkFlushMaxUs(i);
+	#endif
+}
+
+/**
+ * @brief	Periodic one-line self-report, called from the drain task loop;
+ *			does nothing until CONFIG_LOG_STATS_PERIOD has elapsed (0 disables)
+ */
+void vLogStatsReport(void) {
+	#if CONFIG_LOG_STATS_PERIOD > 0
+	uint32_t NowMs = esp_log_timestamp();
+	if (NowMs - sLastReport < (CONFIG_LOG_STATS_PERIOD * 1000UL))
+		return;
+	sLastReport = NowMs;
+	esp_log_stats_t sStats;
+	esp_log_stats_get(&sStats);
+	uint32_t FlushMax = 0;
+	#if CONFIG_LOG_SINKS
+	for (int i = 0; i < CONFIG_LOG_SINK_MAX; ++i) {
+		if (sStats.SinkFlushMaxUs[i] > FlushMax)
+			FlushMax = sStats.SinkFlushMaxUs[i];
+	}
+	#endif
+	vSyslog(ESP_LOG_INFO + 2, "logstats", "E:%u W:%u I:%u D:%u V:%u lockTO:%u drops:%u flushmax:%uus",
+			sStats.MsgCount[ESP_LOG_ERROR], sStats.MsgCount[ESP_LOG_WARN],
+			sStats.MsgCount[ESP_LOG_INFO], sStats.MsgCount[ESP_LOG_DEBUG],
+			sStats.MsgCount[ESP_LOG_VERBOSE], sStats.LockTimeouts,
+			sStats.RingDrops, FlushMax);
+	#endif	// CONFIG_LOG_STATS_PERIOD
+}
+
+#endif	// CONFIG_LOG_STATS
@@ -0,0 +1,95 @@
+/*
+ * log_struct.c - structured key=value logging (see esp_log_struct.h)
+ * Copyright (c) 2024 Andre M. Maree / KSS Technologies (Pty) Ltd.
+ *
+ * Telemetry-shaped output ("rssi=%d vbat=%u state=%s") previously paid a full
+ * vsnprintf per line. The ESP_SLOG macros capture raw typed values (a few
+ * stores each) and this renderer emits "key=value" text with dedicated
+ * integer/string emitters - no printf machinery anywhere on the path. The
+ * rendered record then rides the normal dispatch (deferred ring / sinks), so
+ * per-sink handling, filtering and batching all apply.
+ */
+
+#include "sdkconfig.h"
+
+#if CONFIG_LOG_STRUCT
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_log_struct.h"
+
+// ########################################### Macros ##############################################
+
+#define	logSLOG_BUF_SIZE			160
+
+// ##################################### private functions #########################################
+
+static char * pcLogEmitU32(char * pcBuf, uint32_t Val) {
+	char Tmp[10];
+	int i = 0;
+	do {
+		Tmp[i++] = '0' + (Val % 10);
+		Val /= 10;
+	} while (Val);
+	while (i)
+		*pcBuf++ = Tmp[--i];
+	return pcBuf;
+}
+
+static char * pcLogEmitX32(char * pcBuf, uint32_t Val) {
+	static const char Digits[] = "0123456789abcdef";
+	*pcBuf++ = '0';
+	*pcBuf++ = 'x';
+	for (int i = 28; i >= 0; i -= 4)
+		*pcBuf++ = Digits[(Val >> i) & 0x0F];
+	return pcBuf;
+}
+
+static char * pcLogEmitStr(char * pcBuf, const char * pcStr, int Max) {
+	if (pcStr == NULL)
+		pcStr = "(null)";
+	while (*pcStr && Max-- > 0)					// Max <= 0 writes nothing, never wraps
+		*pcBuf++ = *pcStr++;
+	return pcBuf;
+}
+
+// #################################### public/global functions ####################################
+
+void esp_slog_write(esp_log_level_t level, const char * tag, uint32_t count, const esp_log_kv_t * kvs) {
+	char Buf[logSLOG_BUF_SIZE];
+	char * pc = Buf;
+	char * pcLim = Buf + sizeof(Buf) - 16;			// slack for one numeric value + NUL
+	for (uint32_t i = 0; i < count && pc < pcLim; ++i) {
+		const esp_log_kv_t * psKV = &kvs[i];
+		if (i)
+			*pc++ = ' ';
+		pc = pcLogEmitStr(pc, psKV->key, pcLim - pc);
+		if (pc >= pcLim)
+			break;									// key filled the buffer, drop the rest
+		*pc++ = '=';
+		switch (psKV->type) {
+		case espKV_I32:
+			if (psKV->v.i32 < 0) {
+				*pc++ = '-';
+				pc = pcLogEmitU32(pc, (uint32_t) -psKV->v.i32);
+			} else {
+				pc = pcLogEmitU32(pc, (uint32_t) psKV->v.i32);
+			}
+			break;
+		case espKV_U32:
+			pc = pcLogEmitU32(pc, psKV->v.u32);
+			break;
+		case espKV_X32:
+			pc = pcLogEmitX32(pc, psKV->v.u32);
+			break;
+		case espKV_STR:
+			pc = pcLogEmitStr(pc, psKV->v.str, pcLim - pc);
+			break;
+		}
+	}
+	*pc = 0;
+	esp_log_write(level, tag, "%s", Buf);
+}
+
+#endif	// CONFIG_LOG_STRUCT
@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+"""Decode CONFIG_LOG_BINARY_FORMAT records captured from the console.
+
+Usage: log_decode.py app.elf capture.bin [-]
+       ('-' reads the capture from stdin, e.g. piped from a serial dump)
+
+Record layout (little-endian, see log_binary.c):
+    u8  SOF (0xA5), u8 level, u8 nargs, u8 xor-check
+    u32 format string address, u32 tag address, u32 timestamp-ms
+    u32 args[nargs]
+
+Strings are recovered from the ELF loadable segments, so literals in flash
+(.log_fmt, .rodata) decode; runtime %s buffers render as <0xADDR>.
+"""
+
+import re
+import struct
+import sys
+
+ELF_MAGIC = b"\x7fELF"
+SOF = 0xA5
+HDR = struct.Struct("<BBBBIII")
+
+
+class ElfImage:
+    """Minimal 32-bit LE ELF reader: address -> bytes via program headers."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            data = f.read()
+        if data[:4] != ELF_MAGIC or data[4] != 1 or data[5] != 1:
+            raise SystemExit("%s: not a 32-bit little-endian ELF" % path)
+        e_phoff, = struct.unpack_from("<I", data, 28)
+        e_phentsize, e_phnum = struct.unpack_from("<HH", data, 42)
+        self.segments = []
+        for i in range(e_phnum):
+            p_type, p_offset, p_vaddr, _, p_filesz = struct.unpack_from(
+                "<IIIII", data, e_phoff + i * e_phentsize)
+            if p_type == 1 and p_filesz:  # PT_LOAD
+                self.segments.append((p_vaddr, data[p_offset:p_offset + p_filesz]))
+
+    def string_at(self, addr):
+        for vaddr, blob in self.segments:
+            if vaddr <= addr < vaddr + len(blob):
+                end = blob.find(b"\0", addr - vaddr)
+                if end < 0:
+                    break
+                return blob[addr - vaddr:end].decode("utf-8", "replace")
+        return None
+
+
+def render(elf, fmt, args):
+    args = list(args)
+
+    def sub(m):
+        if not args:
+            return m.group(0)
+        conv = m.group(0)[-1]
+        val = args.pop(0)
+        if conv == "s":
+            s = elf.string_at(val)
+            return s if s is not None else "<0x%08X>" % val
+        if conv == "c":
+            return chr(val & 0xFF)
+        if conv == "%":
+            args.insert(0, val)
+            return "%"
+        # C length modifiers (%zu, %lld, ...) mean nothing to Python's %;
+        # arguments are 32-bit words regardless, so just drop them
+        spec = re.sub(r"(?:hh|h|ll|l|z)(?=.$)", "", m.group(0))
+        if conv == "p":
+            return "0x%08x" % val  # Python % has no 'p' conversion
+        if conv in "di" and val >= 1 << 31:
+            val -= 1 << 32
+        try:
+            return spec % val
+        except (ValueError, TypeError):
+            return m.group(0)  # mis-matched spec: keep it visible, decode the rest
+
+    return re.sub(r"%[-+ #0]*[0-9]*(?:\.[0-9]+)?(?:hh|h|l|ll|z)?[diouxXcsp%]", sub, fmt)
+
+
+def main():
+    if len(sys.argv) != 3:
+        raise SystemExit(__doc__)
+    elf = ElfImage(sys.argv[1])
+    if sys.argv[2] == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        with open(sys.argv[2], "rb") as f:
+            data = f.read()
+
+    pos = 0
+    while pos + HDR.size <= len(data):
+        if data[pos] != SOF:
+            pos += 1
+            continue
+        sof, level, nargs, check, fmt_addr, tag_addr, tstamp = HDR.unpack_from(data, pos)
+        size = HDR.size + 4 * nargs
+        if nargs > 10 or pos + size > len(data):
+            pos += 1
+            continue
+        rec = bytearray(data[pos:pos + size])
+        rec[3] = 0
+        xor = 0
+        for b in rec:
+            xor ^= b
+        if xor != check:
+            pos += 1
+            continue
+        args = struct.unpack_from("<%dI" % nargs, data, pos + HDR.size)
+        fmt = elf.string_at(fmt_addr) or "<fmt 0x%08X>" % fmt_addr
+        tag = elf.string_at(tag_addr) or "<tag 0x%08X>" % tag_addr
+        print("%c (%u) %s: %s" % ("NEWIDV"[level] if level < 6 else "?",
+                                  tstamp, tag, render(elf, fmt, args)))
+        pos += size
+
+
+if __name__ == "__main__":
+    main()
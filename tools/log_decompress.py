@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+"""Decode a log stream compressed by log_compress.c (CONFIG_LOG_COMPRESS).
+
+Bitstream (MSB first): flag 1 = literal (8 data bits); flag 0 = back
+reference, WINDOW bits (distance - 1) + LOOKAHEAD bits (length - 2).
+A truncated token at end of stream is discarded. Window/lookahead bit
+widths must match the device's CONFIG_LOG_COMPRESS_WINDOW / _LOOKAHEAD.
+
+Usage: log_decompress.py [-w BITS] [-l BITS] stream.bin > log.txt
+"""
+import argparse
+import sys
+
+
+class BitReader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0        # bit position
+
+    def take(self, n):
+        """Return n bits MSB first, or None on a truncated stream."""
+        if self.pos + n > len(self.data) * 8:
+            return None
+        val = 0
+        for _ in range(n):
+            byte = self.data[self.pos >> 3]
+            val = (val << 1) | ((byte >> (7 - (self.pos & 7))) & 1)
+            self.pos += 1
+        return val
+
+
+def decompress(data, win_bits, look_bits):
+    out = bytearray()
+    bits = BitReader(data)
+    while True:
+        flag = bits.take(1)
+        if flag is None:
+            break
+        if flag:
+            lit = bits.take(8)
+            if lit is None:
+                break
+            out.append(lit)
+        else:
+            dist = bits.take(win_bits)
+            length = bits.take(look_bits)
+            if dist is None or length is None:
+                break
+            dist += 1
+            if dist > len(out):
+                break       # padding / corrupt tail
+            for _ in range(length + 2):
+                out.append(out[-dist])
+    return bytes(out)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("-w", "--window", type=int, default=8,
+                    help="CONFIG_LOG_COMPRESS_WINDOW (default 8)")
+    ap.add_argument("-l", "--lookahead", type=int, default=4,
+                    help="CONFIG_LOG_COMPRESS_LOOKAHEAD (default 4)")
+    ap.add_argument("stream", help="compressed stream (- for stdin)")
+    args = ap.parse_args()
+    if args.stream == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.stream, "rb") as f:
+            data = f.read()
+    sys.stdout.buffer.write(decompress(data, args.window, args.lookahead))
+
+
+if __name__ == "__main__":
+    main()
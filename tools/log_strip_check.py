@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""Verify a built image carries no DEBUG/VERBOSE log format strings.
+
+Usage: log_strip_check.py image.{elf|bin} srcdir [srcdir ...]
+
+Scans the source tree(s) for ESP_LOGD / ESP_LOGV callsites (plus the EARLY,
+DRAM and _ID variants), extracts each callsite's format string literal, then
+searches the image bytes for it. With LOG_LOCAL_LEVEL / the per-component
+bounds in log_levels_project.h capping a release build at INFO, every one of
+those literals must have been discarded by the compiler; any hit means a TU is
+being compiled with the wrong bound and the report pinpoints the callsite.
+
+Exit status 0 when the image is clean, 1 when any D/V string survives. The
+summary also totals the candidate bytes, i.e. the flash the cap reclaims.
+"""
+
+import os
+import re
+import sys
+
+CALLSITE = re.compile(r"\bESP_(?:EARLY_|DRAM_)?LOG[DV](?:_ID)?\s*\(")
+SRC_EXT = (".c", ".cc", ".cpp", ".h", ".hpp")
+MIN_MATCH = 4   # shorter literals match flash noise, report but don't fail
+
+C_ESCAPES = {"n": "\n", "t": "\t", "r": "\r", "0": "\0", "\\": "\\",
+             '"': '"', "'": "'", "a": "\a", "b": "\b", "f": "\f", "v": "\v"}
+
+
+def unescape(lit):
+    out, i = [], 0
+    while i < len(lit):
+        c = lit[i]
+        if c == "\\" and i + 1 < len(lit):
+            n = lit[i + 1]
+            if n == "x":
+                m = re.match(r"[0-9A-Fa-f]{1,2}", lit[i + 2:])
+                if m:
+                    out.append(chr(int(m.group(0), 16)))
+                    i += 2 + len(m.group(0))
+                    continue
+            if n in C_ESCAPES:
+                out.append(C_ESCAPES[n])
+                i += 2
+                continue
+        out.append(c)
+        i += 1
+    return "".join(out)
+
+
+def call_args(text, start):
+    """Split the argument list opening at text[start] == '(' on top-level commas."""
+    depth, in_str, arg, args, i = 0, False, [], [], start
+    while i < len(text):
+        c = text[i]
+        if in_str:
+            arg.append(c)
+            if c == "\\":
+                arg.append(text[i + 1])
+                i += 1
+            elif c == '"':
+                in_str = False
+        elif c == '"':
+            in_str = True
+            arg.append(c)
+        elif c in "([{":
+            depth += 1
+            if depth > 1:
+                arg.append(c)
+        elif c in ")]}":
+            depth -= 1
+            if depth == 0:
+                args.append("".join(arg))
+                return args
+            arg.append(c)
+        elif c == "," and depth == 1:
+            args.append("".join(arg))
+            arg = []
+        else:
+            arg.append(c)
+        i += 1
+    return None     # unbalanced (macro split across files?), skip
+
+
+def fmt_literal(arg):
+    """Concatenated string literal content of one argument, None if not a literal."""
+    parts = re.findall(r'"((?:[^"\\]|\\.)*)"', arg)
+    if not parts:
+        return None
+    return unescape("".join(parts))
+
+
+def collect(srcdirs):
+    sites = []      # (path, lineno, fmt)
+    for srcdir in srcdirs:
+        for root, _, files in os.walk(srcdir):
+            for name in files:
+                if not name.endswith(SRC_EXT):
+                    continue
+                path = os.path.join(root, name)
+                try:
+                    with open(path, encoding="utf-8", errors="replace") as f:
+                        text = f.read()
+                except OSError:
+                    continue
+                for m in CALLSITE.finditer(text):
+                    args = call_args(text, m.end() - 1)
+                    if not args or len(args) < 2:
+                        continue
+                    fmt = fmt_literal(args[1])  # args[0] is the tag / module id
+                    if fmt:
+                        line = text.count("\n", 0, m.start()) + 1
+                        sites.append((path, line, fmt))
+    return sites
+
+
+def main():
+    if len(sys.argv) < 3:
+        raise SystemExit(__doc__)
+    with open(sys.argv[1], "rb") as f:
+        image = f.read()
+
+    sites = collect(sys.argv[2:])
+    if not sites:
+        print("no ESP_LOGD/ESP_LOGV callsites found under %s" % " ".join(sys.argv[2:]))
+        return 0
+
+    leaked = skipped = 0
+    total = sum(len(fmt) + 1 for _, _, fmt in sites)
+    for path, line, fmt in sites:
+        blob = fmt.encode("utf-8", "replace")
+        if len(blob) < MIN_MATCH:
+            skipped += 1
+            continue
+        if blob in image:
+            leaked += len(blob) + 1
+            print("LEAK %s:%d: %r" % (path, line, fmt))
+    print("%d D/V callsites, %d bytes of format text capped out of the image"
+          % (len(sites), total - leaked))
+    if skipped:
+        print("%d literals shorter than %d bytes not checked (would match noise)"
+              % (skipped, MIN_MATCH))
+    if leaked:
+        print("FAIL: %d bytes of DEBUG/VERBOSE text present in %s"
+              % (leaked, sys.argv[1]))
+        return 1
+    print("OK: no DEBUG/VERBOSE format strings in %s" % sys.argv[1])
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())